@@ -0,0 +1,211 @@
+// Persistent asset cache, shared by every way MSRLWeb loads files
+// (scripts, imports, the asset pack, and raylib's LoadFileData/LoadFileText).
+//
+// Responses are kept in IndexedDB, keyed by absolute URL (so two games
+// served from one origin, e.g. /game1/ and /game2/, never share entries).
+// The first time a URL is requested in a session, we revalidate it with the
+// server using its ETag / Last-Modified (so an unchanged file costs a 304,
+// not a download); after that, the cached copy is used directly.  The cache is bounded in size,
+// evicting the least recently used entries first.
+//
+// Set Module.assetCacheMaxBytes (before the runtime starts) to change the
+// size limit, or to 0 to disable the cache entirely.
+
+Module.assetCache = (function() {
+    var DB_NAME = 'msrlweb-asset-cache';
+    var META = 'meta';    // url -> { url, size, lastUsed, etag, lastModified }
+    var DATA = 'data';    // url -> { url, bytes }
+
+    var stats = { hits: 0, misses: 0, revalidated: 0, evictions: 0, bytes: 0, entries: 0 };
+    var validated = {};   // URLs already checked with the server this session
+    var dbPromise = null;
+
+    function maxBytes() {
+        return (Module.assetCacheMaxBytes !== undefined) ? Module.assetCacheMaxBytes : 128 * 1024 * 1024;
+    }
+
+    function request(req) {
+        return new Promise(function(resolve, reject) {
+            req.onsuccess = function() { resolve(req.result); };
+            req.onerror = function() { reject(req.error); };
+        });
+    }
+
+    function openDB() {
+        if (!dbPromise) {
+            dbPromise = new Promise(function(resolve) {
+                if (typeof indexedDB === 'undefined' || maxBytes() <= 0) { resolve(null); return; }
+                // Version 1 keyed entries by relative URL; start afresh
+                var req = indexedDB.open(DB_NAME, 2);
+                req.onupgradeneeded = function() {
+                    var db = req.result;
+                    if (db.objectStoreNames.contains(META)) db.deleteObjectStore(META);
+                    if (db.objectStoreNames.contains(DATA)) db.deleteObjectStore(DATA);
+                    db.createObjectStore(META, { keyPath: 'url' });
+                    db.createObjectStore(DATA, { keyPath: 'url' });
+                };
+                req.onsuccess = function() {
+                    var db = req.result;
+                    // Seed the size/entry counts from what's already stored
+                    request(db.transaction(META).objectStore(META).getAll()).then(function(metas) {
+                        stats.entries = metas.length;
+                        stats.bytes = metas.reduce(function(sum, m) { return sum + m.size; }, 0);
+                        resolve(db);
+                    }, function() { resolve(db); });
+                };
+                // No IndexedDB (e.g. private browsing): just use the network
+                req.onerror = function() { resolve(null); };
+            });
+        }
+        return dbPromise;
+    }
+
+    function getMeta(db, url) {
+        return request(db.transaction(META).objectStore(META).get(url));
+    }
+
+    function getBytes(db, url) {
+        return request(db.transaction(DATA).objectStore(DATA).get(url)).then(function(entry) {
+            return entry ? new Uint8Array(entry.bytes) : null;
+        });
+    }
+
+    function touch(db, meta) {
+        meta.lastUsed = Date.now();
+        db.transaction(META, 'readwrite').objectStore(META).put(meta);
+    }
+
+    function evict(db, needed) {
+        var limit = maxBytes();
+        if (stats.bytes + needed <= limit) return Promise.resolve();
+        return request(db.transaction(META).objectStore(META).getAll()).then(function(metas) {
+            metas.sort(function(a, b) { return a.lastUsed - b.lastUsed; });
+            var tx = db.transaction([META, DATA], 'readwrite');
+            for (var i = 0; i < metas.length && stats.bytes + needed > limit; i++) {
+                tx.objectStore(META).delete(metas[i].url);
+                tx.objectStore(DATA).delete(metas[i].url);
+                stats.bytes -= metas[i].size;
+                stats.entries--;
+                stats.evictions++;
+            }
+        });
+    }
+
+    function store(db, url, response, bytes, oldMeta) {
+        if (bytes.length > maxBytes()) return;
+        if (oldMeta) { stats.bytes -= oldMeta.size; stats.entries--; }
+        evict(db, bytes.length).then(function() {
+            var meta = {
+                url: url,
+                size: bytes.length,
+                lastUsed: Date.now(),
+                etag: response.headers.get('ETag'),
+                lastModified: response.headers.get('Last-Modified')
+            };
+            var tx = db.transaction([META, DATA], 'readwrite');
+            tx.objectStore(META).put(meta);
+            tx.objectStore(DATA).put({ url: url, bytes: bytes.buffer });
+            stats.bytes += bytes.length;
+            stats.entries++;
+        }).catch(function(e) {
+            console.warn('Asset cache: could not store ' + url + ': ' + e);
+        });
+    }
+
+    // Read a response body, reporting progress as (loaded, total) if asked
+    function readBody(response, onProgress) {
+        var total = parseInt(response.headers.get('Content-Length')) || 0;
+        if (!onProgress || !response.body || !response.body.getReader) {
+            return response.arrayBuffer().then(function(buf) { return new Uint8Array(buf); });
+        }
+        var reader = response.body.getReader();
+        var chunks = [];
+        var loaded = 0;
+        function pump() {
+            return reader.read().then(function(result) {
+                if (result.done) {
+                    var bytes = new Uint8Array(loaded);
+                    var pos = 0;
+                    chunks.forEach(function(c) { bytes.set(c, pos); pos += c.length; });
+                    return bytes;
+                }
+                chunks.push(result.value);
+                loaded += result.value.length;
+                onProgress(loaded, total);
+                return pump();
+            });
+        }
+        return pump();
+    }
+
+    // Fetch url through the cache.  Resolves to { status, bytes } (bytes is a
+    // Uint8Array, or null on failure); never rejects.
+    function fetchAsset(url, onProgress) {
+        try { url = new URL(url, location.href).href; } catch (e) { /* fetch will report it */ }
+        return openDB().then(function(db) {
+            if (!db) return fetchNetwork(null, url, null, onProgress);
+            return getMeta(db, url).then(function(meta) {
+                if (meta && validated[url]) {
+                    return getBytes(db, url).then(function(bytes) {
+                        if (!bytes) return fetchNetwork(db, url, null, onProgress);
+                        stats.hits++;
+                        touch(db, meta);
+                        return { status: 200, bytes: bytes };
+                    }, function() {
+                        // The cached copy can't be read; go to the network
+                        return fetchNetwork(null, url, null, onProgress);
+                    });
+                }
+                return fetchNetwork(db, url, meta, onProgress);
+            }, function() {
+                return fetchNetwork(null, url, null, onProgress);
+            });
+        }).catch(function(e) {
+            console.warn('Asset cache: could not load ' + url + ': ' + e);
+            return { status: 0, bytes: null };
+        });
+    }
+
+    function fetchNetwork(db, url, meta, onProgress) {
+        var headers = {};
+        if (meta && meta.etag) headers['If-None-Match'] = meta.etag;
+        if (meta && meta.lastModified) headers['If-Modified-Since'] = meta.lastModified;
+        // We do our own revalidation, so keep the browser's HTTP cache out of it
+        return fetch(url, { headers: headers, cache: 'no-store' }).then(function(response) {
+            if (response.status === 304 && meta) {
+                return getBytes(db, url).then(function(bytes) {
+                    if (!bytes) return fetchNetwork(db, url, null, onProgress);
+                    validated[url] = true;
+                    stats.hits++;
+                    stats.revalidated++;
+                    touch(db, meta);
+                    return { status: 200, bytes: bytes };
+                });
+            }
+            if (response.status !== 200) return { status: response.status, bytes: null };
+            return readBody(response, onProgress).then(function(bytes) {
+                validated[url] = true;
+                stats.misses++;
+                if (db) store(db, url, response, bytes, meta);
+                return { status: 200, bytes: bytes };
+            });
+        }).catch(function(e) {
+            // Offline?  A stale copy is better than nothing.
+            if (db && meta) {
+                return getBytes(db, url).then(function(bytes) {
+                    if (!bytes) return { status: 0, bytes: null };
+                    stats.hits++;
+                    return { status: 200, bytes: bytes };
+                }, function() {
+                    return { status: 0, bytes: null };
+                });
+            }
+            return { status: 0, bytes: null };
+        });
+    }
+
+    return {
+        fetch: fetchAsset,
+        stats: stats
+    };
+})();
@@ -18,7 +18,7 @@ extract_functions() {
     local module_name=$1
     local start_pattern=$2
 
-    # Find all SetValue calls between the start pattern and the next "}" at column 1
+    # Find all SetValue and BIND calls between the start pattern and the next "}" at column 1
     awk '
         /^static void '"$start_pattern"'\(/ { in_section=1; next }
         in_section && /^}$/ { in_section=0 }
@@ -27,6 +27,11 @@ extract_functions() {
             fname = substr($0, RSTART+1, RLENGTH-2)
             if (fname != "") print fname
         }
+        in_section && /BIND\(raylibModule, / {
+            match($0, /BIND\(raylibModule, [A-Za-z0-9_]+/)
+            fname = substr($0, RSTART+19, RLENGTH-19)
+            if (fname != "") print fname
+        }
     ' "$INPUT_FILE" | sort
 }
 
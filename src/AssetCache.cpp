@@ -0,0 +1,171 @@
+//
+// AssetCache.cpp
+// MSRLWeb
+//
+// Cached asset fetching (the cache itself lives in asset-cache.js).
+//
+// Results are queued on the JavaScript side and picked up by
+// PollAssetFetches, rather than calling back into C++ when they arrive,
+// since with ASYNCIFY the program may be suspended at that moment.
+//
+
+#include "AssetCache.h"
+#include <emscripten.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+EM_JS(void, assetcache_start, (AssetFetch *_fetch, const char *_url), {
+	if (!Module.assetFetches) Module.assetFetches = { progress: {}, done: [] };
+	const state = Module.assetFetches;
+	state.progress[_fetch] = [0, 0];
+	Module.assetCache.fetch(UTF8ToString(_url), (loaded, total) => {
+		state.progress[_fetch] = [loaded, total];
+	}).then((result) => {
+		state.done.push({ fetch: _fetch, status: result.status, bytes: result.bytes });
+	}, () => {
+		// Shouldn't happen (the cache never rejects), but the caller must hear back
+		state.done.push({ fetch: _fetch, status: 0, bytes: null });
+	});
+});
+
+EM_JS(double, assetcache_progress, (AssetFetch *_fetch, int which), {
+	const p = Module.assetFetches && Module.assetFetches.progress[_fetch];
+	return p ? p[which] : 0;
+});
+
+// Take the next finished fetch off the queue (or return null), copying its
+// data into a malloc'd buffer
+EM_JS(AssetFetch*, assetcache_next_done, (int *_status, char **_data, int *_size), {
+	const state = Module.assetFetches;
+	if (!state || state.done.length == 0) return 0;
+	const d = state.done.shift();
+	delete state.progress[d.fetch];
+	let ptr = 0;
+	let size = 0;
+	if (d.bytes) {
+		size = d.bytes.length;
+		ptr = Module._malloc(size > 0 ? size : 1);
+		HEAPU8.set(d.bytes, ptr);
+	}
+	HEAP32[_status >> 2] = d.status;
+	HEAP32[_data >> 2] = ptr;
+	HEAP32[_size >> 2] = size;
+	return d.fetch;
+});
+
+EM_JS(void, assetcache_stat_start, (AssetStat *_stat, const char *_url), {
+	if (!Module.assetFetches) Module.assetFetches = { progress: {}, done: [] };
+	const state = Module.assetFetches;
+	if (!state.stats) state.stats = [];
+	fetch(UTF8ToString(_url), { method: 'HEAD', cache: 'no-store' }).then((response) => {
+		// A compressed response's length isn't the file's size
+		const length = response.headers.get('Content-Encoding') ? NaN : parseInt(response.headers.get('Content-Length'));
+		const modified = Date.parse(response.headers.get('Last-Modified') || '');
+		state.stats.push({ stat: _stat, status: response.status,
+			size: isNaN(length) ? -1 : length, modified: isNaN(modified) ? 0 : modified / 1000 });
+	}, () => {
+		state.stats.push({ stat: _stat, status: 0, size: -1, modified: 0 });
+	});
+});
+
+EM_JS(AssetStat*, assetcache_next_stat, (int *_status, double *_size, double *_modified), {
+	const state = Module.assetFetches;
+	if (!state || !state.stats || state.stats.length == 0) return 0;
+	const d = state.stats.shift();
+	HEAP32[_status >> 2] = d.status;
+	HEAPF64[_size >> 3] = d.size;
+	HEAPF64[_modified >> 3] = d.modified;
+	return d.stat;
+});
+
+EM_JS(double, assetcache_stat, (const char *name), {
+	return Module.assetCache.stats[UTF8ToString(name)] || 0;
+});
+
+static std::vector<AssetFetch*> pendingFetches;
+
+AssetFetch* FetchAsset(const char *url, AssetFetchCallback onDone, void *userData, AssetFetchCallback onProgress) {
+	AssetFetch *fetch = new AssetFetch();
+	fetch->url = strdup(url);
+	fetch->status = 0;
+	fetch->data = nullptr;
+	fetch->numBytes = 0;
+	fetch->loadedBytes = 0;
+	fetch->totalBytes = 0;
+	fetch->userData = userData;
+	fetch->onDone = onDone;
+	fetch->onProgress = onProgress;
+	pendingFetches.push_back(fetch);
+	assetcache_start(fetch, url);
+	return fetch;
+}
+
+void CloseAssetFetch(AssetFetch *fetch) {
+	if (!fetch) return;
+	free(fetch->url);
+	free(fetch->data);
+	delete fetch;
+}
+
+void PollAssetFetches() {
+	for (AssetFetch *fetch : pendingFetches) {
+		if (!fetch->onProgress) continue;
+		double loaded = assetcache_progress(fetch, 0);
+		if (loaded == fetch->loadedBytes) continue;
+		fetch->loadedBytes = loaded;
+		fetch->totalBytes = assetcache_progress(fetch, 1);
+		fetch->onProgress(fetch);
+	}
+
+	int status, size;
+	char *data;
+	while (AssetFetch *fetch = assetcache_next_done(&status, &data, &size)) {
+		for (size_t i = 0; i < pendingFetches.size(); i++) {
+			if (pendingFetches[i] == fetch) { pendingFetches.erase(pendingFetches.begin() + i); break; }
+		}
+		fetch->status = (unsigned short)status;
+		fetch->data = data;
+		fetch->numBytes = (unsigned long long)size;
+		fetch->loadedBytes = fetch->totalBytes = size;
+		// The callback may close the fetch, or start new ones
+		fetch->onDone(fetch);
+	}
+
+	double statSize, statModified;
+	while (AssetStat *stat = assetcache_next_stat(&status, &statSize, &statModified)) {
+		stat->status = (unsigned short)status;
+		stat->size = statSize;
+		stat->modified = statModified;
+		stat->onDone(stat);
+	}
+}
+
+AssetStat* StatAsset(const char *url, AssetStatCallback onDone, void *userData) {
+	AssetStat *stat = new AssetStat();
+	stat->url = strdup(url);
+	stat->status = 0;
+	stat->size = -1;
+	stat->modified = 0;
+	stat->userData = userData;
+	stat->onDone = onDone;
+	assetcache_stat_start(stat, url);
+	return stat;
+}
+
+void CloseAssetStat(AssetStat *stat) {
+	if (!stat) return;
+	free(stat->url);
+	delete stat;
+}
+
+AssetCacheStats GetAssetCacheStats() {
+	AssetCacheStats stats;
+	stats.hits = (long)assetcache_stat("hits");
+	stats.misses = (long)assetcache_stat("misses");
+	stats.revalidated = (long)assetcache_stat("revalidated");
+	stats.evictions = (long)assetcache_stat("evictions");
+	stats.bytes = assetcache_stat("bytes");
+	stats.entries = (long)assetcache_stat("entries");
+	return stats;
+}
@@ -0,0 +1,70 @@
+//
+// AssetCache.h
+// MSRLWeb
+//
+// Cached asset fetching.  Every file we download goes through the
+// persistent cache in asset-cache.js (IndexedDB, revalidated with
+// ETag/Last-Modified, LRU-bounded), so repeat visits mostly skip the network.
+//
+
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+struct AssetFetch;
+typedef void (*AssetFetchCallback)(AssetFetch *fetch);
+
+// One fetch in progress (or done).  Field names follow emscripten_fetch_t.
+struct AssetFetch {
+	char *url;
+	unsigned short status;		// HTTP status (200 for cache hits); 0 if it failed outright
+	char *data;					// response body, once done (owned by the fetch)
+	unsigned long long numBytes;
+	double loadedBytes;			// download progress, for onProgress
+	double totalBytes;			// (0 if the size isn't known)
+	void *userData;
+	AssetFetchCallback onDone;
+	AssetFetchCallback onProgress;
+};
+
+// Start fetching url.  onDone is called (from PollAssetFetches) when it
+// finishes, successfully or not; onProgress, if given, as data arrives.
+AssetFetch* FetchAsset(const char *url, AssetFetchCallback onDone, void *userData = nullptr,
+					   AssetFetchCallback onProgress = nullptr);
+
+// Free a fetch and its data.  Don't call this until it's done.
+void CloseAssetFetch(AssetFetch *fetch);
+
+// Deliver progress and completion callbacks; call once per frame.
+void PollAssetFetches();
+
+struct AssetCacheStats {
+	long hits;			// served from the cache (including after a 304)
+	long misses;		// downloaded
+	long revalidated;	// hits confirmed by a 304 from the server
+	long evictions;		// entries dropped to stay under the size limit
+	double bytes;		// total size of cached entries
+	long entries;
+};
+
+AssetCacheStats GetAssetCacheStats();
+
+// Size and modification time of a file on the server, from a HEAD request
+// (which bypasses the cache).  Also delivered by PollAssetFetches.
+struct AssetStat;
+typedef void (*AssetStatCallback)(AssetStat *stat);
+
+struct AssetStat {
+	char *url;
+	unsigned short status;		// HTTP status; 0 if it failed outright
+	double size;				// Content-Length, or -1 if unknown (or compressed)
+	double modified;			// Last-Modified, in seconds since 1970, or 0 if unknown
+	void *userData;
+	AssetStatCallback onDone;
+};
+
+AssetStat* StatAsset(const char *url, AssetStatCallback onDone, void *userData = nullptr);
+
+// Free a stat.  Don't call this until it's done.
+void CloseAssetStat(AssetStat *stat);
+
+#endif
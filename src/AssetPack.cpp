@@ -0,0 +1,270 @@
+//
+// AssetPack.cpp
+// MSRLWeb
+//
+// Single-file asset packs: all of assets/ in one indexed (and optionally
+// LZ4-compressed) archive, fetched once at startup and served from memory.
+//
+// Layout (all integers little-endian):
+//   "MSPK"  u32 version  u32 fileCount
+//   per file:  u32 pathBytes, path (UTF-8), u32 offset, u32 storedSize,
+//              u32 size, u8 flags
+//   then the file data; offset is from the start of the pack.
+// A file with kFlagLZ4 set is stored as a single LZ4 block, which expands
+// to size bytes; otherwise storedSize == size and it's stored as-is.
+//
+
+#include "AssetPack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+
+enum PackFlags {
+	kFlagLZ4 = 1
+};
+
+//--------------------------------------------------------------------------------
+// LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md)
+//--------------------------------------------------------------------------------
+
+static const int kMinMatch = 4;
+static const int kLastLiterals = 5;		// the last 5 bytes are always literals
+static const int kMatchFindLimit = 12;	// no match may start in the last 12 bytes
+static const int kHashBits = 12;
+
+static unsigned int Read32(const unsigned char *p) {
+	unsigned int n;
+	memcpy(&n, p, 4);
+	return n;
+}
+
+static void PutLength(std::vector<unsigned char>& out, long len) {
+	while (len >= 255) { out.push_back(255); len -= 255; }
+	out.push_back((unsigned char)len);
+}
+
+static void PutSequence(std::vector<unsigned char>& out, const unsigned char *literals, long litLen,
+						long offset, long matchLen) {
+	long m = matchLen - kMinMatch;
+	out.push_back((unsigned char)(((litLen < 15 ? litLen : 15) << 4) | (matchLen ? (m < 15 ? m : 15) : 0)));
+	if (litLen >= 15) PutLength(out, litLen - 15);
+	out.insert(out.end(), literals, literals + litLen);
+	if (!matchLen) return;	// final, literals-only sequence
+	out.push_back((unsigned char)(offset & 0xFF));
+	out.push_back((unsigned char)(offset >> 8));
+	if (m >= 15) PutLength(out, m - 15);
+}
+
+// Simple greedy compressor: a hash of the next 4 bytes finds the last place
+// we saw them, within the 64K window.  Not as tight as the reference
+// encoder, but packing happens offline and decoding speed is the same.
+static std::vector<unsigned char> LZ4Compress(const unsigned char *src, long size) {
+	std::vector<unsigned char> out;
+	std::vector<long> table(1 << kHashBits, -1);
+	long anchor = 0;
+	long i = 0;
+	while (i < size - kMatchFindLimit) {
+		unsigned int seq = Read32(src + i);
+		unsigned int h = (seq * 2654435761u) >> (32 - kHashBits);
+		long ref = table[h];
+		table[h] = i;
+		if (ref < 0 || i - ref > 65535 || Read32(src + ref) != seq) {
+			i++;
+			continue;
+		}
+		long matchLen = kMinMatch;
+		while (i + matchLen < size - kLastLiterals && src[ref + matchLen] == src[i + matchLen]) matchLen++;
+		PutSequence(out, src + anchor, i - anchor, i - ref, matchLen);
+		i += matchLen;
+		anchor = i;
+	}
+	PutSequence(out, src + anchor, size - anchor, 0, 0);
+	return out;
+}
+
+// Decompress one block into exactly dstSize bytes; false if it's malformed.
+static bool LZ4Decompress(const unsigned char *src, long srcSize, unsigned char *dst, long dstSize) {
+	const unsigned char *ip = src, *iend = src + srcSize;
+	unsigned char *op = dst, *oend = dst + dstSize;
+	while (ip < iend) {
+		unsigned char token = *ip++;
+
+		long litLen = token >> 4;
+		if (litLen == 15) {
+			unsigned char b;
+			do {
+				if (ip >= iend) return false;
+				b = *ip++;
+				litLen += b;
+			} while (b == 255);
+		}
+		if (litLen > iend - ip || litLen > oend - op) return false;
+		memcpy(op, ip, litLen);
+		ip += litLen;
+		op += litLen;
+		if (ip == iend) break;		// that was the final sequence
+
+		if (iend - ip < 2) return false;
+		long offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op - dst) return false;
+
+		long matchLen = token & 15;
+		if (matchLen == 15) {
+			unsigned char b;
+			do {
+				if (ip >= iend) return false;
+				b = *ip++;
+				matchLen += b;
+			} while (b == 255);
+		}
+		matchLen += kMinMatch;
+		if (matchLen > oend - op) return false;
+		// Byte by byte, since the match may overlap what it's copying
+		const unsigned char *match = op - offset;
+		for (long k = 0; k < matchLen; k++) op[k] = match[k];
+		op += matchLen;
+	}
+	return op == oend;
+}
+
+//--------------------------------------------------------------------------------
+// Encoding
+//--------------------------------------------------------------------------------
+
+static void PutU32(std::vector<unsigned char>& out, unsigned long n) {
+	for (int i = 0; i < 4; i++) out.push_back((unsigned char)((n >> (i * 8)) & 0xFF));
+}
+
+static void SetU32(std::vector<unsigned char>& out, size_t pos, unsigned long n) {
+	for (int i = 0; i < 4; i++) out[pos + i] = (unsigned char)((n >> (i * 8)) & 0xFF);
+}
+
+std::vector<unsigned char> EncodeAssetPack(const std::vector<AssetPackInput>& files, bool compress) {
+	std::vector<unsigned char> out = { 'M', 'S', 'P', 'K' };
+	PutU32(out, ASSET_PACK_VERSION);
+	PutU32(out, files.size());
+
+	// Index first, with offsets patched in once we know where the data goes
+	std::vector<size_t> offsetPos;
+	std::vector<std::vector<unsigned char>> stored(files.size());
+	std::vector<unsigned char> flags(files.size(), 0);
+	for (size_t i = 0; i < files.size(); i++) {
+		const AssetPackInput& f = files[i];
+		if (compress && f.data.size() > (size_t)kMatchFindLimit) {
+			std::vector<unsigned char> packed = LZ4Compress(f.data.data(), (long)f.data.size());
+			// Already-compressed formats (PNG, OGG...) won't shrink; store those as-is
+			if (packed.size() < f.data.size() * 9 / 10) {
+				stored[i].swap(packed);
+				flags[i] = kFlagLZ4;
+			}
+		}
+		if (!flags[i]) stored[i] = f.data;
+
+		PutU32(out, f.path.size());
+		out.insert(out.end(), f.path.begin(), f.path.end());
+		offsetPos.push_back(out.size());
+		PutU32(out, 0);
+		PutU32(out, stored[i].size());
+		PutU32(out, f.data.size());
+		out.push_back(flags[i]);
+	}
+
+	for (size_t i = 0; i < files.size(); i++) {
+		SetU32(out, offsetPos[i], out.size());
+		out.insert(out.end(), stored[i].begin(), stored[i].end());
+	}
+	return out;
+}
+
+//--------------------------------------------------------------------------------
+// Mounted pack
+//--------------------------------------------------------------------------------
+
+struct PackedFile {
+	const unsigned char *stored;	// points into the pack
+	long storedSize;
+	long size;
+	unsigned char flags;
+	unsigned char *expanded;		// decompressed copy, made on first use
+};
+
+static std::unordered_map<std::string, PackedFile> packIndex;
+
+static unsigned long GetU32(const unsigned char *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+// Scripts may say "./assets/x.png" as well as "assets/x.png"
+static const char* NormalizePath(const char *path) {
+	while (path[0] == '.' && path[1] == '/') path += 2;
+	return path;
+}
+
+bool MountAssetPack(const unsigned char *data, long size) {
+	if (size < 12 || memcmp(data, "MSPK", 4) != 0) return false;
+	unsigned long version = GetU32(data + 4);
+	if (version != ASSET_PACK_VERSION) {
+		printf("Asset pack is version %lu, but this build expects %d; ignoring it\n",
+			version, ASSET_PACK_VERSION);
+		return false;
+	}
+
+	std::unordered_map<std::string, PackedFile> index;
+	unsigned long count = GetU32(data + 8);
+	long pos = 12;
+	for (unsigned long i = 0; i < count; i++) {
+		if (pos + 4 > size) return false;
+		unsigned long pathLen = GetU32(data + pos);
+		pos += 4;
+		if (pathLen > (unsigned long)(size - pos) || pos + (long)pathLen + 13 > size) return false;
+		std::string path((const char*)(data + pos), pathLen);
+		pos += pathLen;
+
+		unsigned long offset = GetU32(data + pos);
+		PackedFile f;
+		f.storedSize = (long)GetU32(data + pos + 4);
+		f.size = (long)GetU32(data + pos + 8);
+		f.flags = data[pos + 12];
+		f.expanded = nullptr;
+		pos += 13;
+		if (offset > (unsigned long)size || f.storedSize > size - (long)offset) return false;
+		if (!(f.flags & kFlagLZ4) && f.storedSize != f.size) return false;
+		f.stored = data + offset;
+		index[path] = f;
+	}
+
+	for (auto& pair : packIndex) free(pair.second.expanded);
+	packIndex.swap(index);
+	return true;
+}
+
+int GetPackedAssetCount() {
+	return (int)packIndex.size();
+}
+
+bool FindPackedAsset(const char *path, const unsigned char **outData, int *outSize) {
+	if (packIndex.empty() || !path) return false;
+	auto it = packIndex.find(NormalizePath(path));
+	if (it == packIndex.end()) return false;
+
+	PackedFile& f = it->second;
+	if (!(f.flags & kFlagLZ4)) {
+		*outData = f.stored;
+	} else {
+		if (!f.expanded) {
+			unsigned char *buf = (unsigned char*)malloc(f.size > 0 ? f.size : 1);
+			if (!buf) return false;
+			if (!LZ4Decompress(f.stored, f.storedSize, buf, f.size)) {
+				printf("Asset pack: %s is corrupt\n", it->first.c_str());
+				free(buf);
+				return false;
+			}
+			f.expanded = buf;
+		}
+		*outData = f.expanded;
+	}
+	*outSize = (int)f.size;
+	return true;
+}
@@ -0,0 +1,42 @@
+//
+// AssetPack.h
+// MSRLWeb
+//
+// Single-file asset packs: all of assets/ in one indexed (and optionally
+// LZ4-compressed) archive, fetched once at startup and served from memory.
+//
+
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <string>
+#include <vector>
+
+// Bump this whenever the pack layout changes.  Packs with any other
+// version are ignored (assets are then fetched one by one, as usual).
+#define ASSET_PACK_VERSION 1
+
+// One file to pack, under the path scripts will load it by (e.g. "assets/Wumpus.png")
+struct AssetPackInput {
+	std::string path;
+	std::vector<unsigned char> data;
+};
+
+// Build a pack from the given files.  With compress, each file is LZ4
+// compressed, but only where that actually makes it smaller.
+std::vector<unsigned char> EncodeAssetPack(const std::vector<AssetPackInput>& files, bool compress);
+
+// Make the files in a pack available to FindPackedAsset.  The pack data is
+// not copied, so it must stay valid for as long as the pack is mounted.
+// Returns false (and mounts nothing) if the data isn't a valid pack.
+bool MountAssetPack(const unsigned char *data, long size);
+
+// Number of files in the mounted pack (0 if none)
+int GetPackedAssetCount();
+
+// Look up a file in the mounted pack.  On success, outData points directly
+// into the pack (zero-copy; compressed files are expanded on first use and
+// kept), and stays valid while the pack is mounted.
+bool FindPackedAsset(const char *path, const unsigned char **outData, int *outSize);
+
+#endif
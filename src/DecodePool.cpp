@@ -0,0 +1,116 @@
+//
+// DecodePool.cpp
+// MSRLWeb
+//
+// Image and audio decoding off the main thread (see DecodePool.h)
+//
+
+#include "DecodePool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifdef MSRLWEB_THREADS
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+// Jobs with a callback, waiting for PollDecodeJobs (main thread only)
+static std::vector<DecodeJob*> watchedJobs;
+
+static void RunDecode(DecodeJob *job) {
+	const char *ext = GetFileExtension(job->path);
+	switch (job->kind) {
+		case kDecodeImage:
+			job->image = LoadImageFromMemory(ext, job->data, job->size);
+			break;
+		case kDecodeWave:
+			job->wave = LoadWaveFromMemory(ext, job->data, job->size);
+			break;
+		default:
+			break;
+	}
+	job->done.store(true);
+}
+
+#ifdef MSRLWEB_THREADS
+
+static const int kMaxWorkers = 4;
+
+static std::mutex queueMutex;
+static std::condition_variable queueReady;
+static std::deque<DecodeJob*> queue;
+static bool workersStarted = false;
+
+static void WorkerMain() {
+	for (;;) {
+		DecodeJob *job;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueReady.wait(lock, [] { return !queue.empty(); });
+			job = queue.front();
+			queue.pop_front();
+		}
+		RunDecode(job);
+	}
+}
+
+// Threads come from the prewarmed pool (PTHREAD_POOL_SIZE), so starting
+// them here doesn't have to wait on the browser.
+static void StartWorkers() {
+	int count = (int)std::thread::hardware_concurrency() - 1;
+	if (count < 1) count = 1;
+	if (count > kMaxWorkers) count = kMaxWorkers;
+	for (int i = 0; i < count; i++) std::thread(WorkerMain).detach();
+	workersStarted = true;
+}
+
+#endif
+
+DecodeJob* StartDecode(DecodeKind kind, const char *path, const unsigned char *data, int size,
+					   DecodeJobCallback onDone, void *userData) {
+	DecodeJob *job = new DecodeJob();
+	job->kind = kind;
+	job->path = strdup(path);
+	job->data = data;
+	job->size = size;
+	job->image = Image{ 0 };
+	job->wave = Wave{ 0 };
+	job->done.store(false);
+	job->onDone = onDone;
+	job->userData = userData;
+	if (onDone) watchedJobs.push_back(job);
+
+#ifdef MSRLWEB_THREADS
+	if (kind != kDecodeRaw) {
+		if (!workersStarted) StartWorkers();
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			queue.push_back(job);
+		}
+		queueReady.notify_one();
+		return job;
+	}
+#endif
+	RunDecode(job);
+	return job;
+}
+
+void PollDecodeJobs() {
+	for (size_t i = 0; i < watchedJobs.size(); ) {
+		DecodeJob *job = watchedJobs[i];
+		if (!IsDecodeDone(job)) { i++; continue; }
+		watchedJobs.erase(watchedJobs.begin() + i);
+		job->onDone(job);	// may free the job, or start others
+	}
+}
+
+void FreeDecodeJob(DecodeJob *job) {
+	if (!job) return;
+	if (job->image.data) UnloadImage(job->image);
+	if (job->wave.data) UnloadWave(job->wave);
+	free(job->path);
+	delete job;
+}
@@ -0,0 +1,53 @@
+//
+// DecodePool.h
+// MSRLWeb
+//
+// Image and audio decoding off the main thread.  In a threaded build
+// (MSRLWEB_THREADS), a small pool of worker threads decodes fetched file
+// data into Image/Wave buffers, so big sprite sheets and sounds don't stall
+// the frame; only the GPU upload or Sound creation is left for the main
+// thread.  In other builds, jobs simply decode on the spot.
+//
+
+#ifndef DECODEPOOL_H
+#define DECODEPOOL_H
+
+#include "raylib.h"
+#include <atomic>
+
+enum DecodeKind {
+	kDecodeRaw,		// no decoding; the job just carries the data
+	kDecodeImage,
+	kDecodeWave
+};
+
+struct DecodeJob;
+typedef void (*DecodeJobCallback)(DecodeJob *job);
+
+struct DecodeJob {
+	DecodeKind kind;
+	char *path;					// used to pick the format, by file extension
+	const unsigned char *data;	// input (not owned; must outlive the job)
+	int size;
+	Image image;				// result, for kDecodeImage
+	Wave wave;					// result, for kDecodeWave
+	std::atomic<bool> done;
+	DecodeJobCallback onDone;
+	void *userData;
+};
+
+// Start decoding.  If onDone is given, it's called from PollDecodeJobs
+// (on the main thread) once the job is done; otherwise, poll IsDecodeDone.
+DecodeJob* StartDecode(DecodeKind kind, const char *path, const unsigned char *data, int size,
+					   DecodeJobCallback onDone = nullptr, void *userData = nullptr);
+
+inline bool IsDecodeDone(DecodeJob *job) { return job->done.load(); }
+
+// Run callbacks for finished jobs; call once per frame.
+void PollDecodeJobs();
+
+// Free a finished job.  Any image or wave still in it is unloaded too, so
+// take ownership of a result by clearing it from the job (e.g. job->image = {0}).
+void FreeDecodeJob(DecodeJob *job);
+
+#endif
@@ -0,0 +1,121 @@
+//
+// DisplayList.cpp
+// MSRLWeb
+//
+// Recorded drawing: between BeginDisplayListCapture and
+// EndDisplayListCapture, rlgl batches into a render batch of our own, and
+// at the end we copy out its vertices, colors, texture coordinates and draw
+// calls.  Replaying them later is one native loop, however many draw calls
+// made them.
+//
+
+#include "DisplayList.h"
+#include "rlgl.h"
+
+static rlRenderBatch captureBatch;
+static bool captureBatchLoaded = false;
+static bool capturing = false;
+
+// Every capture starts with this degenerate (zero-area, transparent) quad.
+// If rlgl flushes the batch during the capture, the marker goes with it,
+// which is how we know the recording is incomplete.
+static const float kMarkerX = -32768.5f, kMarkerY = -32768.25f;
+static const int kMarkerVertices = 4;
+
+static void DrawCaptureMarker() {
+	rlSetTexture(rlGetTextureIdDefault());
+	rlBegin(RL_QUADS);
+	rlColor4ub(0, 0, 0, 0);
+	for (int v = 0; v < kMarkerVertices; v++) {
+		rlTexCoord2f(0, 0);
+		rlVertex2f(kMarkerX, kMarkerY);
+	}
+	rlEnd();
+	rlSetTexture(0);
+}
+
+static bool CaptureMarkerIntact() {
+	if (captureBatch.drawCounter < 1 || captureBatch.draws[0].vertexCount < kMarkerVertices) return false;
+	const float *v = captureBatch.vertexBuffer[captureBatch.currentBuffer].vertices;
+	return v[0] == kMarkerX && v[1] == kMarkerY;
+}
+
+bool BeginDisplayListCapture() {
+	if (capturing) return false;
+	// Loaded on first use, since it needs the GL context
+	if (!captureBatchLoaded) {
+		captureBatch = rlLoadRenderBatch(1, kDisplayListMaxVertices / 4);
+		captureBatchLoaded = true;
+	}
+	// This draws whatever was already batched, so the capture starts empty
+	rlSetRenderBatchActive(&captureBatch);
+	DrawCaptureMarker();
+	capturing = true;
+	return true;
+}
+
+DisplayList* EndDisplayListCapture(DisplayListCaptureResult *outResult) {
+	if (outResult) *outResult = kDisplayListNotCapturing;
+	if (!capturing) return nullptr;
+	capturing = false;
+
+	if (!CaptureMarkerIntact()) {
+		if (outResult) *outResult = kDisplayListFlushed;
+		rlSetRenderBatchActive(nullptr);
+		return nullptr;
+	}
+
+	DisplayList *list = new DisplayList();
+	const rlVertexBuffer& buffer = captureBatch.vertexBuffer[captureBatch.currentBuffer];
+	int vertex = 0;
+	for (int d = 0; d < captureBatch.drawCounter; d++) {
+		const rlDrawCall& call = captureBatch.draws[d];
+		// Skip the marker, at the start of the first draw call
+		int skip = d == 0 ? kMarkerVertices : 0;
+		if (call.vertexCount > skip) {
+			list->draws.push_back(DisplayListDraw{ call.mode, call.textureId, (int)list->positions.size(), call.vertexCount - skip });
+			for (int v = vertex + skip; v < vertex + call.vertexCount; v++) {
+				list->positions.push_back(Vector2{ buffer.vertices[v*3], buffer.vertices[v*3 + 1] });
+				list->texcoords.push_back(Vector2{ buffer.texcoords[v*2], buffer.texcoords[v*2 + 1] });
+				const unsigned char *c = &buffer.colors[v*4];
+				list->colors.push_back(Color{ c[0], c[1], c[2], c[3] });
+			}
+		}
+		// Lines and triangles are padded out to whole quads in the buffer
+		vertex += call.vertexCount + call.vertexAlignment;
+	}
+
+	// Switching back draws (and empties) the capture batch
+	rlSetRenderBatchActive(nullptr);
+	if (outResult) *outResult = kDisplayListCaptured;
+	return list;
+}
+
+bool IsCapturingDisplayList() {
+	return capturing;
+}
+
+void DrawDisplayList(const DisplayList& list, Vector2 position, float rotation, float scale) {
+	rlPushMatrix();
+	rlTranslatef(position.x, position.y, 0);
+	if (rotation != 0) rlRotatef(rotation, 0, 0, 1);
+	if (scale != 1) rlScalef(scale, scale, 1);
+
+	for (const DisplayListDraw& draw : list.draws) {
+		int perPrimitive = draw.mode == RL_LINES ? 2 : (draw.mode == RL_TRIANGLES ? 3 : 4);
+		rlSetTexture(draw.textureId);
+		rlBegin(draw.mode);
+		for (int v = draw.first; v < draw.first + draw.count; v++) {
+			// Flushes (and resumes) the batch if a whole primitive won't fit
+			if ((v - draw.first) % perPrimitive == 0) rlCheckRenderBatchLimit(perPrimitive);
+			const Color& c = list.colors[v];
+			rlColor4ub(c.r, c.g, c.b, c.a);
+			rlTexCoord2f(list.texcoords[v].x, list.texcoords[v].y);
+			rlVertex2f(list.positions[v].x, list.positions[v].y);
+		}
+		rlEnd();
+	}
+	rlSetTexture(0);
+
+	rlPopMatrix();
+}
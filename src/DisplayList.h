@@ -0,0 +1,62 @@
+//
+// DisplayList.h
+// MSRLWeb
+//
+// Recorded drawing: between BeginDisplayListCapture and
+// EndDisplayListCapture, rlgl batches into a render batch of our own, and
+// at the end we copy out its vertices, colors, texture coordinates and draw
+// calls.  Replaying them later is one native loop, however many draw calls
+// made them.
+//
+
+#ifndef DISPLAYLIST_H
+#define DISPLAYLIST_H
+
+#include "raylib.h"
+#include <vector>
+
+struct DisplayListDraw {
+	int mode;				// RL_LINES, RL_TRIANGLES or RL_QUADS
+	unsigned int textureId;
+	int first;				// index of its first vertex
+	int count;
+};
+
+struct DisplayList {
+	std::vector<DisplayListDraw> draws;
+	std::vector<Vector2> positions;
+	std::vector<Vector2> texcoords;
+	std::vector<Color> colors;
+};
+
+// Most vertices one capture can hold.  rlgl also flushes its batch after
+// RL_DEFAULT_BATCH_DRAWCALLS (256) draw calls, i.e. changes of texture or
+// primitive, and on anything that changes render state, such as
+// BeginTextureMode or BeginBlendMode.  Any flush loses what was recorded
+// before it, so the capture fails.
+static const int kDisplayListMaxVertices = 65536;
+
+// Start recording.  Returns false if already recording.
+bool BeginDisplayListCapture();
+
+enum DisplayListCaptureResult {
+	kDisplayListCaptured,
+	kDisplayListNotCapturing,
+	kDisplayListFlushed		// over one of the limits above; nothing returned
+};
+
+// Stop recording, and return what was drawn (nullptr if not recording, or
+// if the capture failed).  The recorded drawing is also drawn now, as it
+// would have been anyway.
+//
+// A list refers to textures only by their GL ids: whatever owns them must
+// keep them loaded for as long as the list is drawn.
+DisplayList* EndDisplayListCapture(DisplayListCaptureResult *outResult = nullptr);
+
+bool IsCapturingDisplayList();
+
+// Replay a list, moved by position, and rotated (in degrees) and scaled
+// about its origin
+void DrawDisplayList(const DisplayList& list, Vector2 position, float rotation, float scale);
+
+#endif
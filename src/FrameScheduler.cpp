@@ -0,0 +1,105 @@
+//
+// FrameScheduler.cpp
+// MSRLWeb
+//
+// Frame-budget-aware time slicing for the MiniScript main loop
+//
+
+#include "FrameScheduler.h"
+#include "raylib.h"
+#include <stdio.h>
+
+// Never give the VM less than this, so a slow browser can't starve the script
+static const double kMinSlice = 0.001;
+
+static double frameBudget = 1.0 / 60.0;
+static double hostEstimate = 0.002;		// host time per frame (smoothed)
+static double sliceStart = 0;
+static double sliceLimit = 1.0 / 60.0;
+static double frameStart = 0;
+static double lastFrameEnd = 0;
+static double sliceTime = 0;			// spent in the script this frame
+static double hostTime = 0;				// spent outside it this frame
+static bool frameHadSlice = false;
+static bool lastSliceSaturated = false;
+static bool inSlice = false;
+static bool waitedThisSlice = false;
+static long overrunCount = 0;
+
+void SetFrameBudget(double seconds) {
+	if (seconds < kMinSlice) seconds = kMinSlice;
+	frameBudget = seconds;
+}
+
+double GetFrameBudget() {
+	return frameBudget;
+}
+
+double BeginScriptSlice() {
+	double now = GetTime();
+
+	if (hostEstimate > frameBudget * 0.5) hostEstimate = frameBudget * 0.5;
+
+	double slice = frameBudget - hostEstimate;
+	if (slice < kMinSlice) slice = kMinSlice;
+
+	sliceStart = now;
+	sliceLimit = slice;
+	inSlice = true;
+	waitedThisSlice = false;
+	return slice;
+}
+
+void EndScriptSlice() {
+	double now = GetTime();
+	double elapsed = now - sliceStart;
+	inSlice = false;
+	sliceTime = elapsed;
+	frameHadSlice = true;
+
+	// RunUntilDone only returns at the time limit if the script didn't
+	// yield, or was waiting on I/O the whole time (which is fine)
+	lastSliceSaturated = (elapsed >= sliceLimit);
+	if (lastSliceSaturated && !waitedThisSlice) {
+		overrunCount++;
+		// Log the first few, then only occasionally, so a script stuck in a
+		// long loop doesn't flood the console.
+		if (overrunCount <= 10 || overrunCount % 100 == 0) {
+			printf("Frame overrun #%ld: script ran %.1f ms without yielding (budget %.1f ms)\n",
+				overrunCount, elapsed * 1000, sliceLimit * 1000);
+		}
+	}
+	// An I/O wait says nothing about the browser's time either
+	if (waitedThisSlice) lastSliceSaturated = false;
+}
+
+void BeginFrameTiming() {
+	frameStart = GetTime();
+	// The gap since the last frame is the browser's work, but only when the
+	// VM used its whole slice; after a slice that yielded early, it also
+	// includes idle time waiting for the next animation frame.
+	hostTime = (lastSliceSaturated && lastFrameEnd > 0) ? frameStart - lastFrameEnd : 0;
+	frameHadSlice = false;
+	sliceTime = 0;
+}
+
+void EndFrameTiming() {
+	lastFrameEnd = GetTime();
+	if (!frameHadSlice) return;		// loading screens etc. tell us nothing
+	hostTime += lastFrameEnd - frameStart - sliceTime;
+	hostEstimate = hostEstimate * 0.9 + hostTime * 0.1;
+}
+
+void NoteScriptWaiting() {
+	waitedThisSlice = true;
+}
+
+double GetFrameBudgetRemaining() {
+	if (!inSlice) return sliceLimit;
+	double remaining = sliceStart + sliceLimit - GetTime();
+	return remaining > 0 ? remaining : 0;
+}
+
+long GetFrameOverrunCount() {
+	return overrunCount;
+}
@@ -0,0 +1,39 @@
+//
+// FrameScheduler.h
+// MSRLWeb
+//
+// Frame-budget-aware time slicing for the MiniScript main loop
+//
+
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+// Set/get the total time (in seconds) we aim to spend on each frame,
+// including the work the browser does between our main loop calls.
+void SetFrameBudget(double seconds);
+double GetFrameBudget();
+
+// Call around each RunUntilDone: BeginScriptSlice returns how long the VM
+// may run this frame; EndScriptSlice records whether it overran.
+double BeginScriptSlice();
+void EndScriptSlice();
+
+// Call at the very start and end of each main loop iteration.  Whatever
+// the frame spends outside the script slice (fetch and decode polling,
+// resource collection, rendering) is measured every frame and taken out
+// of later slices.
+void BeginFrameTiming();
+void EndFrameTiming();
+
+// Call from an intrinsic that returns a partial result because it's waiting
+// on a fetch or decode.  The VM keeps re-invoking it until the slice runs
+// out, but that isn't the script failing to yield, so it isn't an overrun.
+void NoteScriptWaiting();
+
+// Time left (in seconds) in the current script slice
+double GetFrameBudgetRemaining();
+
+// Number of frames where the script used up its whole slice without yielding
+long GetFrameOverrunCount();
+
+#endif
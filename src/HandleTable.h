@@ -0,0 +1,92 @@
+//
+// HandleTable.h
+// MSRLWeb
+//
+// Dense, typed tables of raylib resources, addressed by generational handles.
+// A handle packs a slot index with that slot's generation; the generation is
+// bumped whenever the slot is freed, so a handle that outlives its resource
+// (or is freed twice) is detected instead of pointing at garbage.
+//
+
+#ifndef HANDLETABLE_H
+#define HANDLETABLE_H
+
+#include <vector>
+
+// 0 is never a valid handle, so it can stand for "no resource"
+typedef unsigned int ResourceHandle;
+
+static const int kHandleIndexBits = 20;		// up to ~1M live resources of each kind
+static const unsigned int kHandleIndexMask = (1u << kHandleIndexBits) - 1;
+static const unsigned int kHandleMaxGeneration = (1u << (32 - kHandleIndexBits)) - 1;
+
+template <class T>
+class HandleTable {
+public:
+	// Store item in a free slot, and return its handle (0 if the table is full).
+	ResourceHandle Add(const T& item) {
+		unsigned int index;
+		if (!freeSlots.empty()) {
+			index = freeSlots.back();
+			freeSlots.pop_back();
+		} else {
+			if (slots.size() > kHandleIndexMask) return 0;
+			index = (unsigned int)slots.size();
+			slots.push_back(Slot{ T(), 1, false });
+		}
+		Slot& slot = slots[index];
+		slot.item = item;
+		slot.live = true;
+		liveCount++;
+		return (slot.generation << kHandleIndexBits) | index;
+	}
+
+	// The item a handle refers to, or nullptr if the handle is stale or bogus.
+	T* Get(ResourceHandle handle) {
+		unsigned int index = handle & kHandleIndexMask;
+		if (index >= slots.size()) return nullptr;
+		Slot& slot = slots[index];
+		if (!slot.live || slot.generation != (handle >> kHandleIndexBits)) return nullptr;
+		return &slot.item;
+	}
+
+	// Free a handle's slot.  Returns false (and does nothing) if the handle
+	// was already freed or is otherwise invalid.
+	bool Remove(ResourceHandle handle) {
+		T* item = Get(handle);
+		if (!item) return false;
+		unsigned int index = handle & kHandleIndexMask;
+		Slot& slot = slots[index];
+		slot.live = false;
+		slot.item = T();
+		// Generation 0 is skipped so that no handle is ever 0
+		slot.generation = (slot.generation == kHandleMaxGeneration) ? 1 : slot.generation + 1;
+		freeSlots.push_back(index);
+		liveCount--;
+		return true;
+	}
+
+	int LiveCount() const { return liveCount; }
+
+	// Call f(handle, item) for each live item.  f may Remove the handle
+	// it's given (or any other).
+	template <class F>
+	void ForEach(F f) {
+		for (size_t index = 0; index < slots.size(); index++) {
+			Slot& slot = slots[index];
+			if (slot.live) f((slot.generation << kHandleIndexBits) | (unsigned int)index, slot.item);
+		}
+	}
+
+private:
+	struct Slot {
+		T item;
+		unsigned int generation;
+		bool live;
+	};
+	std::vector<Slot> slots;
+	std::vector<unsigned int> freeSlots;
+	int liveCount = 0;
+};
+
+#endif
@@ -0,0 +1,164 @@
+//
+// ParticleEmitter.cpp
+// MSRLWeb
+//
+// Native particle systems.  Each emitter owns a fixed pool of particles,
+// stored as parallel arrays and kept densely packed (a dead particle's slot
+// is filled by the last live one), so emitting, updating and drawing never
+// allocate.  Particles are drawn with one SpriteBatch per emitter.
+//
+
+#include "ParticleEmitter.h"
+#include "rlgl.h"
+#include <math.h>
+
+float FloatCurve::Evaluate(float t) const {
+	if (count <= 1) return count ? stops[0] : 0;
+	float pos = t * (count - 1);
+	int i = (int)pos;
+	if (i >= count - 1) return stops[count - 1];
+	float f = pos - i;
+	return stops[i] + (stops[i + 1] - stops[i]) * f;
+}
+
+Color ColorCurve::Evaluate(float t) const {
+	if (count <= 1) return count ? stops[0] : WHITE;
+	float pos = t * (count - 1);
+	int i = (int)pos;
+	if (i >= count - 1) return stops[count - 1];
+	float f = pos - i;
+	const Color& a = stops[i];
+	const Color& b = stops[i + 1];
+	return Color{ (unsigned char)(a.r + (b.r - a.r) * f), (unsigned char)(a.g + (b.g - a.g) * f),
+		(unsigned char)(a.b + (b.b - a.b) * f), (unsigned char)(a.a + (b.a - a.a) * f) };
+}
+
+ParticleSettings DefaultParticleSettings() {
+	ParticleSettings s;
+	s.rate = 0;
+	s.lifeMin = s.lifeMax = 1;
+	s.speedMin = 0;
+	s.speedMax = 100;
+	s.direction = 0;
+	s.spread = 180;
+	s.gravity = Vector2{ 0, 0 };
+	s.drag = 0;
+	s.sizes.count = 1;
+	s.sizes.stops[0] = 4;
+	s.speeds.count = 1;
+	s.speeds.stops[0] = 1;
+	s.colors.count = 1;
+	s.colors.stops[0] = WHITE;
+	s.texture = Texture2D{};
+	s.source = Rectangle{ 0, 0, 0, 0 };
+	return s;
+}
+
+ParticleEmitter::ParticleEmitter(int maxParticles) : settings(DefaultParticleSettings()) {
+	if (maxParticles < 1) maxParticles = 1;
+	x.resize(maxParticles);
+	y.resize(maxParticles);
+	vx.resize(maxParticles);
+	vy.resize(maxParticles);
+	age.resize(maxParticles);
+	life.resize(maxParticles);
+	tint.resize(maxParticles);
+	instances.resize(maxParticles);
+}
+
+// xorshift32; plenty for particles, and cheaper than GetRandomValue
+float ParticleEmitter::Random(float lo, float hi) {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return lo + (hi - lo) * (float)((seed >> 8) * (1.0 / 16777216.0));
+}
+
+int ParticleEmitter::Emit(int n, Vector2 at, Color color) {
+	int room = Capacity() - count;
+	if (n > room) n = room;
+	for (int k = 0; k < n; k++) {
+		int i = count++;
+		float angle = (settings.direction + Random(-settings.spread, settings.spread)) * DEG2RAD;
+		float speed = Random(settings.speedMin, settings.speedMax);
+		x[i] = at.x;
+		y[i] = at.y;
+		vx[i] = cosf(angle) * speed;
+		vy[i] = sinf(angle) * speed;
+		age[i] = 0;
+		life[i] = Random(settings.lifeMin, settings.lifeMax);
+		tint[i] = color;
+	}
+	return n > 0 ? n : 0;
+}
+
+void ParticleEmitter::Kill(int i) {
+	int last = --count;
+	x[i] = x[last];
+	y[i] = y[last];
+	vx[i] = vx[last];
+	vy[i] = vy[last];
+	age[i] = age[last];
+	life[i] = life[last];
+	tint[i] = tint[last];
+}
+
+void ParticleEmitter::Update(float dt) {
+	if (settings.rate > 0) {
+		emitDebt += settings.rate * dt;
+		int n = (int)emitDebt;
+		emitDebt -= n;
+		Emit(n, position, WHITE);
+	}
+
+	float gx = settings.gravity.x * dt, gy = settings.gravity.y * dt;
+	float slow = settings.drag * dt;
+	bool curvedSpeed = settings.speeds.count > 1 || settings.speeds.stops[0] != 1;
+	for (int i = 0; i < count;) {
+		age[i] += dt;
+		if (age[i] >= life[i]) {
+			Kill(i);		// moves another particle into i; don't advance
+			continue;
+		}
+		if (slow > 0) {
+			float speed = sqrtf(vx[i] * vx[i] + vy[i] * vy[i]);
+			float factor = speed > slow ? (speed - slow) / speed : 0;
+			vx[i] *= factor;
+			vy[i] *= factor;
+		}
+		vx[i] += gx;
+		vy[i] += gy;
+		float s = curvedSpeed ? settings.speeds.Evaluate(age[i] / life[i]) : 1;
+		x[i] += vx[i] * s * dt;
+		y[i] += vy[i] * s * dt;
+		i++;
+	}
+}
+
+void ParticleEmitter::Draw() {
+	if (count == 0) return;
+	Texture2D texture = settings.texture;
+	Rectangle src = settings.source;
+	if (texture.id == 0) {
+		// rlgl's default texture is a single white pixel
+		texture = Texture2D{ rlGetTextureIdDefault(), 1, 1, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+		src = Rectangle{ 0, 0, 1, 1 };
+	} else if (src.width == 0 || src.height == 0) {
+		src = Rectangle{ 0, 0, (float)texture.width, (float)texture.height };
+	}
+
+	for (int i = 0; i < count; i++) {
+		float t = age[i] / life[i];
+		float size = settings.sizes.Evaluate(t);
+		Color c = settings.colors.Evaluate(t);
+		const Color& k = tint[i];
+		SpriteInstance& inst = instances[i];
+		inst.source = src;
+		inst.dest = Rectangle{ x[i], y[i], size, size };
+		inst.origin = Vector2{ size * 0.5f, size * 0.5f };
+		inst.rotation = 0;
+		inst.tint = Color{ (unsigned char)(c.r * k.r / 255), (unsigned char)(c.g * k.g / 255),
+			(unsigned char)(c.b * k.b / 255), (unsigned char)(c.a * k.a / 255) };
+	}
+	DrawSpriteBatch(texture, instances.data(), count);
+}
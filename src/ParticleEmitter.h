@@ -0,0 +1,85 @@
+//
+// ParticleEmitter.h
+// MSRLWeb
+//
+// Native particle systems.  Each emitter owns a fixed pool of particles,
+// stored as parallel arrays and kept densely packed (a dead particle's slot
+// is filled by the last live one), so emitting, updating and drawing never
+// allocate.  Particles are drawn with one SpriteBatch per emitter.
+//
+
+#ifndef PARTICLEEMITTER_H
+#define PARTICLEEMITTER_H
+
+#include "raylib.h"
+#include "SpriteBatch.h"
+#include <vector>
+
+// A value that changes over a particle's life: stops spaced evenly from
+// birth to death, linearly interpolated in between
+static const int kMaxCurveStops = 8;
+
+struct FloatCurve {
+	float stops[kMaxCurveStops];
+	int count;
+	float Evaluate(float t) const;
+};
+
+struct ColorCurve {
+	Color stops[kMaxCurveStops];
+	int count;
+	Color Evaluate(float t) const;
+};
+
+// The shortest particle life; Update and Draw divide by it
+static const float kMinParticleLife = 0.001f;
+
+struct ParticleSettings {
+	float rate;					// particles per second emitted by Update
+	float lifeMin, lifeMax;		// seconds (at least kMinParticleLife)
+	float speedMin, speedMax;	// initial speed, units per second
+	float direction;			// degrees (0 is to the right, 90 down)
+	float spread;				// degrees either side of direction
+	Vector2 gravity;			// units per second per second
+	float drag;					// speed lost per second (as in UpdateSprites)
+	FloatCurve sizes;			// width and height, over life
+	FloatCurve speeds;			// velocity multiplier, over life
+	ColorCurve colors;			// over life, times each particle's tint
+	Texture2D texture;			// id 0: plain squares
+	Rectangle source;			// 0 width or height: the whole texture
+};
+
+ParticleSettings DefaultParticleSettings();
+
+class ParticleEmitter {
+public:
+	explicit ParticleEmitter(int maxParticles);
+
+	ParticleSettings settings;
+	Vector2 position = { 0, 0 };
+
+	// Start count particles at position, tinted; returns how many fit in the pool
+	int Emit(int count, Vector2 at, Color tint);
+
+	// Emit at the current rate (from position), then move and age every
+	// particle, by dt seconds
+	void Update(float dt);
+
+	void Draw();
+
+	int Count() const { return count; }
+	int Capacity() const { return (int)x.size(); }
+
+private:
+	std::vector<float> x, y, vx, vy, age, life;
+	std::vector<Color> tint;
+	int count = 0;
+	float emitDebt = 0;		// fractional particles owed by the rate
+	unsigned int seed = 0x9E3779B9u;
+	std::vector<SpriteInstance> instances;	// scratch space for Draw
+
+	float Random(float lo, float hi);
+	void Kill(int i);
+};
+
+#endif
@@ -15,4 +15,12 @@ namespace MiniScript {
 // Add Raylib intrinsics to the global state
 void AddRaylibIntrinsics();
 
+// Release the raylib resources (textures, sounds, etc.) whose maps the
+// script no longer references.  In MSRLWEB_LEAK_CHECK builds, these are
+// reported as leaks instead.  Call once per frame.
+void CollectDroppedResources();
+
+// In MSRLWEB_LEAK_CHECK builds, list the resources still loaded
+void ReportLiveResources();
+
 #endif // RAYLIBINTRINSICS_H
@@ -0,0 +1,78 @@
+//
+// ScreenLayers.cpp
+// MSRLWeb
+//
+// Retained screen layers: each layer is a render texture that the script
+// redraws only when its content changes.  Visible layers are composited
+// onto the screen in z order, so a layer that didn't change costs one
+// textured quad instead of a full redraw.  Layers with z < 0 go beneath
+// the script's own drawing (right after it clears the screen), and layers
+// with z >= 0 go over it (at the end of the frame).
+//
+
+#include "ScreenLayers.h"
+#include <algorithm>
+#include <vector>
+
+static std::vector<ScreenLayer*> layers;
+static unsigned long nextSerial = 0;
+static ScreenLayer *openLayer = nullptr;
+static bool lowerDrawn = false;		// this frame, by CompositeLowerScreenLayers
+
+ScreenLayer* CreateScreenLayer(int width, int height, int z) {
+	if (width <= 0) width = GetScreenWidth();
+	if (height <= 0) height = GetScreenHeight();
+	ScreenLayer *layer = new ScreenLayer{ LoadRenderTexture(width, height), z, true, true, nextSerial++ };
+	layers.push_back(layer);
+	return layer;
+}
+
+void DestroyScreenLayer(ScreenLayer *layer) {
+	if (layer == openLayer) EndScreenLayer();
+	layers.erase(std::remove(layers.begin(), layers.end(), layer), layers.end());
+	UnloadRenderTexture(layer->target);
+	delete layer;
+}
+
+bool BeginScreenLayer(ScreenLayer *layer) {
+	if (openLayer) return false;
+	openLayer = layer;
+	BeginTextureMode(layer->target);
+	ClearBackground(BLANK);
+	return true;
+}
+
+void EndScreenLayer() {
+	if (!openLayer) return;
+	EndTextureMode();
+	openLayer->dirty = false;
+	openLayer = nullptr;
+}
+
+// Draw the visible layers below z = 0, or the rest
+static void DrawLayers(bool lower) {
+	std::sort(layers.begin(), layers.end(), [](const ScreenLayer *a, const ScreenLayer *b) {
+		return a->z < b->z || (a->z == b->z && a->serial < b->serial);
+	});
+	for (const ScreenLayer *layer : layers) {
+		if (!layer->visible || layer->target.id == 0 || (layer->z < 0) != lower) continue;
+		const Texture2D& texture = layer->target.texture;
+		// Render textures are stored upside down, hence the negative height
+		Rectangle src = { 0, 0, (float)texture.width, -(float)texture.height };
+		DrawTextureRec(texture, src, Vector2{ 0, 0 }, WHITE);
+	}
+}
+
+void CompositeLowerScreenLayers() {
+	lowerDrawn = true;
+	if (!layers.empty()) DrawLayers(true);
+}
+
+void CompositeUpperScreenLayers() {
+	bool lower = !lowerDrawn;
+	lowerDrawn = false;
+	if (layers.empty()) return;
+	if (openLayer) EndScreenLayer();		// forgotten EndScreenLayer
+	if (lower) DrawLayers(true);
+	DrawLayers(false);
+}
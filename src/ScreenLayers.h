@@ -0,0 +1,44 @@
+//
+// ScreenLayers.h
+// MSRLWeb
+//
+// Retained screen layers: each layer is a render texture that the script
+// redraws only when its content changes.  Visible layers are composited
+// onto the screen in z order, so a layer that didn't change costs one
+// textured quad instead of a full redraw.  Layers with z < 0 go beneath
+// the script's own drawing (right after it clears the screen), and layers
+// with z >= 0 go over it (at the end of the frame).
+//
+
+#ifndef SCREENLAYERS_H
+#define SCREENLAYERS_H
+
+#include "raylib.h"
+
+struct ScreenLayer {
+	RenderTexture2D target;
+	int z;					// higher is drawn later (on top)
+	bool visible;
+	bool dirty;				// content needs redrawing (set by the script)
+	unsigned long serial;	// creation order, to break ties in z
+};
+
+// Make a layer of the given size (0 for the screen's), initially dirty
+ScreenLayer* CreateScreenLayer(int width, int height, int z);
+void DestroyScreenLayer(ScreenLayer *layer);
+
+// Draw into a layer (cleared to transparent first); false if another layer
+// is already open.  EndScreenLayer marks it clean.
+bool BeginScreenLayer(ScreenLayer *layer);
+void EndScreenLayer();
+
+// Draw the visible layers with z < 0 onto the screen, lowest z first.
+// Call right after the screen is cleared.
+void CompositeLowerScreenLayers();
+
+// Draw the visible layers with z >= 0 over the screen, lowest z first, at
+// the end of a frame.  If the screen wasn't cleared this frame, the z < 0
+// layers are drawn first.
+void CompositeUpperScreenLayers();
+
+#endif
@@ -0,0 +1,357 @@
+//
+// ScriptBundle.cpp
+// MSRLWeb
+//
+// Precompiled MiniScript bundles: main.ms plus its imports, already
+// compiled to TAC, so the runtime can skip parsing at startup.
+//
+// Layout (all integers little-endian):
+//   "MSRB"  u32 version  u32 moduleCount
+//   per module: str name, str sourcePath, f64 sourceSize, f64 sourceTime,
+//               function
+//   function:   u32 paramCount, (str name, value default)*,
+//               u32 lineCount, (u8 op, value lhs, value rhsA, value rhsB,
+//                               str locationContext, i32 locationLine)*
+//   str:        u32 byteCount, UTF-8 bytes
+//   value:      u8 tag, then a tag-specific payload (see ValueTag)
+//
+
+#include "ScriptBundle.h"
+#include "MiniscriptTAC.h"
+#include "MiniscriptLexer.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace MiniScript;
+
+enum ValueTag {
+	kTagNull = 0,
+	kTagNumber,		// f64
+	kTagString,		// str
+	kTagList,		// u32 count, value*
+	kTagMap,		// u32 count, (value key, value val)*
+	kTagFunction,	// function
+	kTagTemp,		// i32 temp number
+	kTagVar,		// u8 noInvoke, str identifier
+	kTagSeqElem		// u8 noInvoke, value sequence, value index
+};
+
+//--------------------------------------------------------------------------------
+// Encoding
+//--------------------------------------------------------------------------------
+
+class BundleWriter {
+public:
+	std::vector<unsigned char> bytes;
+
+	void U8(unsigned char b) { bytes.push_back(b); }
+
+	void U32(unsigned long n) {
+		for (int i = 0; i < 4; i++) bytes.push_back((unsigned char)((n >> (i * 8)) & 0xFF));
+	}
+
+	void F64(double d) {
+		unsigned char buf[8];
+		memcpy(buf, &d, 8);
+		bytes.insert(bytes.end(), buf, buf + 8);
+	}
+
+	void Str(const String& s) {
+		U32(s.LengthB());
+		bytes.insert(bytes.end(), s.c_str(), s.c_str() + s.LengthB());
+	}
+
+	void Val(const Value& v);
+	void Function(FunctionStorage *func);
+};
+
+static long TempNumber(const Value& v) {
+	return v.data.tempNum;
+}
+
+// Vars keep their identifier as String storage, so read it back out by
+// viewing the value as a string.
+static String VarName(const Value& v) {
+	Value s = v;
+	s.type = ValueType::String;
+	return s.ToString();
+}
+
+void BundleWriter::Val(const Value& v) {
+	switch (v.type) {
+		case ValueType::Number:
+			U8(kTagNumber);
+			F64(v.DoubleValue());
+			break;
+		case ValueType::String:
+			U8(kTagString);
+			Str(v.ToString());
+			break;
+		case ValueType::List: {
+			ValueList list = v.GetList();
+			U8(kTagList);
+			U32(list.Count());
+			for (long i = 0; i < list.Count(); i++) Val(list[i]);
+			break;
+		}
+		case ValueType::Map: {
+			ValueDict map = v.GetDict();
+			ValueList keys = map.Keys();
+			U8(kTagMap);
+			U32(keys.Count());
+			for (long i = 0; i < keys.Count(); i++) {
+				Val(keys[i]);
+				Val(map.Lookup(keys[i], Value::null));
+			}
+			break;
+		}
+		case ValueType::Function:
+			U8(kTagFunction);
+			Function((FunctionStorage*)v.data.ref);
+			break;
+		case ValueType::Temp:
+			U8(kTagTemp);
+			U32((unsigned long)TempNumber(v));
+			break;
+		case ValueType::Var:
+			U8(kTagVar);
+			U8(v.noInvoke ? 1 : 0);
+			Str(VarName(v));
+			break;
+		case ValueType::SeqElem: {
+			SeqElemStorage *elem = (SeqElemStorage*)v.data.ref;
+			U8(kTagSeqElem);
+			U8(v.noInvoke ? 1 : 0);
+			Val(elem->sequence);
+			Val(elem->index);
+			break;
+		}
+		default:
+			U8(kTagNull);
+			break;
+	}
+}
+
+void BundleWriter::Function(FunctionStorage *func) {
+	U32(func->parameters.Count());
+	for (long i = 0; i < func->parameters.Count(); i++) {
+		Str(func->parameters[i].name);
+		Val(func->parameters[i].defaultValue);
+	}
+	U32(func->code.Count());
+	for (long i = 0; i < func->code.Count(); i++) {
+		TACLine& line = func->code[i];
+		U8((unsigned char)line.op);
+		Val(line.lhs);
+		Val(line.rhsA);
+		Val(line.rhsB);
+		Str(line.location.context);
+		U32((unsigned long)line.location.lineNum);
+	}
+}
+
+std::vector<unsigned char> EncodeScriptBundle(const std::vector<BundledModule>& modules) {
+	BundleWriter w;
+	w.bytes.insert(w.bytes.end(), { 'M', 'S', 'R', 'B' });
+	w.U32(SCRIPT_BUNDLE_VERSION);
+	w.U32(modules.size());
+	for (const BundledModule& m : modules) {
+		w.Str(m.name);
+		w.Str(m.sourcePath);
+		w.F64(m.sourceSize);
+		w.F64(m.sourceTime);
+		w.Function(m.func);
+	}
+	return w.bytes;
+}
+
+//--------------------------------------------------------------------------------
+// Decoding
+//--------------------------------------------------------------------------------
+
+class BundleReader {
+public:
+	const unsigned char *data;
+	long size;
+	long pos;
+	bool ok;
+
+	BundleReader(const unsigned char *data, long size) : data(data), size(size), pos(0), ok(true) {}
+
+	bool Need(long n) {
+		if (!ok || pos + n > size) ok = false;
+		return ok;
+	}
+
+	unsigned char U8() {
+		if (!Need(1)) return 0;
+		return data[pos++];
+	}
+
+	unsigned long U32() {
+		if (!Need(4)) return 0;
+		unsigned long n = 0;
+		for (int i = 0; i < 4; i++) n |= ((unsigned long)data[pos++]) << (i * 8);
+		return n;
+	}
+
+	double F64() {
+		double d = 0;
+		if (!Need(8)) return d;
+		memcpy(&d, data + pos, 8);
+		pos += 8;
+		return d;
+	}
+
+	String Str() {
+		unsigned long len = U32();
+		if (!Need(len)) return String();
+		String s((const char*)(data + pos), len);
+		pos += len;
+		return s;
+	}
+
+	Value Val(int depth = 0);
+	FunctionStorage* Function(int depth);
+};
+
+Value BundleReader::Val(int depth) {
+	// Nested literals and functions are never this deep in real code;
+	// treat it as corruption rather than risk blowing the stack.
+	if (depth > 64) { ok = false; return Value::null; }
+
+	switch (U8()) {
+		case kTagNumber:
+			return Value(F64());
+		case kTagString:
+			return Value(Str());
+		case kTagList: {
+			unsigned long count = U32();
+			ValueList list;
+			for (unsigned long i = 0; i < count && ok; i++) list.Add(Val(depth + 1));
+			return Value(list);
+		}
+		case kTagMap: {
+			unsigned long count = U32();
+			ValueDict map;
+			for (unsigned long i = 0; i < count && ok; i++) {
+				Value key = Val(depth + 1);
+				map.SetValue(key, Val(depth + 1));
+			}
+			return Value(map);
+		}
+		case kTagFunction: {
+			FunctionStorage *func = Function(depth + 1);
+			if (!func) return Value::null;
+			return Value(func);
+		}
+		case kTagTemp:
+			return Value::Temp((long)U32());
+		case kTagVar: {
+			bool noInvoke = U8() != 0;
+			Value v = Value::Var(Str());
+			v.noInvoke = noInvoke;
+			return v;
+		}
+		case kTagSeqElem: {
+			bool noInvoke = U8() != 0;
+			Value seq = Val(depth + 1);
+			Value idx = Val(depth + 1);
+			Value v = Value::SeqElem(seq, idx);
+			v.noInvoke = noInvoke;
+			return v;
+		}
+		default:
+			return Value::null;
+	}
+}
+
+FunctionStorage* BundleReader::Function(int depth) {
+	FunctionStorage *func = new FunctionStorage();
+	unsigned long paramCount = U32();
+	for (unsigned long i = 0; i < paramCount && ok; i++) {
+		String name = Str();
+		func->parameters.Add(FuncParam(name, Val(depth)));
+	}
+	unsigned long lineCount = U32();
+	for (unsigned long i = 0; i < lineCount && ok; i++) {
+		TACLine::Op op = (TACLine::Op)U8();
+		Value lhs = Val(depth);
+		Value rhsA = Val(depth);
+		Value rhsB = Val(depth);
+		TACLine line(lhs, op, rhsA, rhsB);
+		line.location.context = Str();
+		line.location.lineNum = (int)U32();
+		func->code.Add(line);
+	}
+	return func;
+}
+
+bool DecodeScriptBundle(const unsigned char *data, long size, std::vector<BundledModule>& modules) {
+	modules.clear();
+	if (size < 12 || memcmp(data, "MSRB", 4) != 0) return false;
+
+	BundleReader r(data, size);
+	r.pos = 4;
+	unsigned long version = r.U32();
+	if (version != SCRIPT_BUNDLE_VERSION) {
+		printf("Script bundle is version %lu, but this build expects %d; ignoring it\n",
+			version, SCRIPT_BUNDLE_VERSION);
+		return false;
+	}
+	unsigned long count = r.U32();
+	for (unsigned long i = 0; i < count && r.ok; i++) {
+		BundledModule m;
+		m.name = r.Str();
+		m.sourcePath = r.Str();
+		m.sourceSize = r.F64();
+		m.sourceTime = r.F64();
+		m.func = r.Function(0);
+		modules.push_back(m);
+	}
+	if (!r.ok) {
+		printf("Script bundle is truncated or corrupt; ignoring it\n");
+		modules.clear();
+		return false;
+	}
+	return true;
+}
+
+bool BundledSourceMatches(const BundledModule& module, double size, double modified) {
+	if (size >= 0 && size != module.sourceSize) return false;
+	// HTTP dates have whole-second precision
+	if (modified > 0 && modified != floor(module.sourceTime)) return false;
+	return true;
+}
+
+FunctionStorage* FindBundledModule(const std::vector<BundledModule>& modules, const String& name) {
+	for (const BundledModule& m : modules) {
+		if (m.name == name) return m.func;
+	}
+	return nullptr;
+}
+
+//--------------------------------------------------------------------------------
+// Import scanning
+//--------------------------------------------------------------------------------
+
+void FindImportNames(const String& source, std::vector<String>& names) {
+	try {
+		Lexer lexer(source);
+		while (!lexer.AtEnd()) {
+			Token tok = lexer.Dequeue();
+			if (tok.type != Token::Type::Identifier || tok.text != "import") continue;
+			// Accept both `import "x"` and `import("x")`
+			if (!lexer.AtEnd() && lexer.Peek().type == Token::Type::LParen) lexer.Dequeue();
+			if (lexer.AtEnd() || lexer.Peek().type != Token::Type::String) continue;
+			String name = lexer.Dequeue().text;
+			bool seen = false;
+			for (const String& n : names) if (n == name) { seen = true; break; }
+			if (!seen) names.push_back(name);
+		}
+	} catch (MiniscriptException& mse) {
+		// The parser will report this properly when the script runs;
+		// for scanning purposes, just keep what we found so far.
+	}
+}
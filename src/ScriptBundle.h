@@ -0,0 +1,58 @@
+//
+// ScriptBundle.h
+// MSRLWeb
+//
+// Precompiled MiniScript bundles: main.ms plus its imports, already
+// compiled to TAC, so the runtime can skip parsing at startup.
+//
+
+#ifndef SCRIPTBUNDLE_H
+#define SCRIPTBUNDLE_H
+
+#include "SimpleString.h"
+#include <vector>
+
+namespace MiniScript {
+	class FunctionStorage;
+}
+
+// Bump this whenever the bundle layout, or the MiniScript TAC it encodes,
+// changes.  Bundles with any other version are ignored (we fall back to source).
+#define SCRIPT_BUNDLE_VERSION 3
+
+// One compiled module.  The entry script (main.ms) is stored with an empty
+// name; everything else is stored under its import name.  Each module also
+// records where its source was (relative to the assets directory) and that
+// file's size and modification time, so the runtime can tell when the
+// source has been edited since the bundle was built.
+struct BundledModule {
+	MiniScript::String name;
+	MiniScript::FunctionStorage *func;
+	MiniScript::String sourcePath;
+	double sourceSize;
+	double sourceTime;		// seconds since 1970
+	BundledModule() : func(nullptr), sourceSize(0), sourceTime(0) {}
+	BundledModule(MiniScript::String name, MiniScript::FunctionStorage *func)
+		: name(name), func(func), sourceSize(0), sourceTime(0) {}
+};
+
+// Serialize the given modules (each an import function, as made by
+// Parser::CreateImport) into a bundle.
+std::vector<unsigned char> EncodeScriptBundle(const std::vector<BundledModule>& modules);
+
+// Decode a bundle into modules.  Returns false if the data isn't a bundle
+// of the current version (or is truncated), in which case modules is empty.
+bool DecodeScriptBundle(const unsigned char *data, long size, std::vector<BundledModule>& modules);
+
+// Whether a source file on the server (as reported by StatAsset: size -1
+// and time 0 mean unknown) could still be the one a module was built from
+bool BundledSourceMatches(const BundledModule& module, double size, double modified);
+
+// Find a module by name, or return nullptr.
+MiniScript::FunctionStorage* FindBundledModule(const std::vector<BundledModule>& modules, const MiniScript::String& name);
+
+// Scan MiniScript source for `import "name"` statements, appending each
+// library name found (in order of appearance) to names.
+void FindImportNames(const MiniScript::String& source, std::vector<MiniScript::String>& names);
+
+#endif
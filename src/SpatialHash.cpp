@@ -0,0 +1,201 @@
+//
+// SpatialHash.cpp
+// MSRLWeb
+//
+// Broad-phase collision index: circles and rectangles are bucketed into a
+// uniform grid of square cells, so overlap and picking queries only test
+// colliders that share a cell.  Meant to be cleared and refilled each frame.
+//
+// Rather than a hash table of per-cell lists, the index is one array of
+// (cell, collider) entries, sorted by cell the first time it's queried after
+// a change.  Filling it is then just appends, and a cell's colliders are
+// contiguous.  Colliders covering too many cells are kept out of the grid,
+// in a short list that every query checks.
+//
+
+#include "SpatialHash.h"
+#include <algorithm>
+#include <math.h>
+
+// A collider more cells than this across (or down) is oversized
+static const int kMaxCellSpan = 64;
+
+static bool IsFiniteRec(Rectangle r) {
+	return isfinite(r.x) && isfinite(r.y) && isfinite(r.width) && isfinite(r.height);
+}
+
+static long long CellKey(int cx, int cy) {
+	return ((long long)cy << 32) | (unsigned int)cx;
+}
+
+SpatialHash::SpatialHash(float cellSize) : cellSize(cellSize > 0 ? cellSize : 64) {
+}
+
+void SpatialHash::Clear() {
+	colliders.clear();
+	entries.clear();
+	oversized.clear();
+	built = true;
+}
+
+int SpatialHash::CellOf(float coord) const {
+	float c = floorf(coord / cellSize);
+	if (!(c > -1e9f)) return -1000000000;	// also catches NaN
+	if (c > 1e9f) return 1000000000;
+	return (int)c;
+}
+
+int SpatialHash::Add(const Collider& c) {
+	int id = (int)colliders.size();
+	colliders.push_back(c);
+	Collider& added = colliders.back();
+	added.oversized = added.ignored = false;
+	if (!IsFiniteRec(c.bounds)) {
+		// Keep the id (callers number their items by it), but nothing more
+		added.ignored = true;
+		added.minX = added.minY = 0;
+		added.maxX = added.maxY = -1;
+		return id;
+	}
+	added.minX = CellOf(c.bounds.x);
+	added.minY = CellOf(c.bounds.y);
+	added.maxX = CellOf(c.bounds.x + c.bounds.width);
+	added.maxY = CellOf(c.bounds.y + c.bounds.height);
+	if ((long long)added.maxX - added.minX >= kMaxCellSpan || (long long)added.maxY - added.minY >= kMaxCellSpan) {
+		added.oversized = true;
+		oversized.push_back(id);
+		return id;
+	}
+	for (int cy = added.minY; cy <= added.maxY; cy++) {
+		for (int cx = added.minX; cx <= added.maxX; cx++) entries.push_back(CellEntry{ CellKey(cx, cy), id });
+	}
+	built = false;
+	return id;
+}
+
+int SpatialHash::AddCircle(Vector2 center, float radius) {
+	Collider c;
+	c.isCircle = true;
+	c.center = center;
+	c.radius = radius;
+	c.bounds = Rectangle{ center.x - radius, center.y - radius, radius * 2, radius * 2 };
+	return Add(c);
+}
+
+int SpatialHash::AddRec(Rectangle rec) {
+	Collider c;
+	c.isCircle = false;
+	c.center = Vector2{ 0, 0 };
+	c.radius = 0;
+	c.bounds = rec;
+	return Add(c);
+}
+
+void SpatialHash::Build() {
+	if (built) return;
+	std::sort(entries.begin(), entries.end(), [](const CellEntry& a, const CellEntry& b) {
+		return a.cell < b.cell || (a.cell == b.cell && a.id < b.id);
+	});
+	built = true;
+}
+
+std::pair<size_t, size_t> SpatialHash::FindCell(int cx, int cy) const {
+	long long key = CellKey(cx, cy);
+	auto range = std::equal_range(entries.begin(), entries.end(), CellEntry{ key, 0 },
+		[](const CellEntry& a, const CellEntry& b) { return a.cell < b.cell; });
+	return std::make_pair((size_t)(range.first - entries.begin()), (size_t)(range.second - entries.begin()));
+}
+
+bool SpatialHash::Overlaps(const Collider& a, const Collider& b) const {
+	if (a.isCircle && b.isCircle) return CheckCollisionCircles(a.center, a.radius, b.center, b.radius);
+	if (a.isCircle) return CheckCollisionCircleRec(a.center, a.radius, b.bounds);
+	if (b.isCircle) return CheckCollisionCircleRec(b.center, b.radius, a.bounds);
+	return CheckCollisionRecs(a.bounds, b.bounds);
+}
+
+void SpatialHash::FindPairs(std::vector<std::pair<int, int>>& outPairs) {
+	Build();
+	size_t start = 0;
+	while (start < entries.size()) {
+		size_t end = start + 1;
+		while (end < entries.size() && entries[end].cell == entries[start].cell) end++;
+		int cx = (int)(unsigned int)(entries[start].cell & 0xFFFFFFFF);
+		int cy = (int)(entries[start].cell >> 32);
+		for (size_t i = start; i < end; i++) {
+			const Collider& a = colliders[entries[i].id];
+			for (size_t j = i + 1; j < end; j++) {
+				const Collider& b = colliders[entries[j].id];
+				// A pair sharing several cells is reported only from the
+				// first of them (the top-left corner of their overlap)
+				if (cx != std::max(a.minX, b.minX) || cy != std::max(a.minY, b.minY)) continue;
+				if (Overlaps(a, b)) outPairs.push_back(std::make_pair(entries[i].id, entries[j].id));
+			}
+		}
+		start = end;
+	}
+
+	// Oversized colliders are checked against everything else (and each
+	// other, once per pair)
+	for (int big : oversized) {
+		for (int id = 0; id < (int)colliders.size(); id++) {
+			const Collider& c = colliders[id];
+			if (id == big || c.ignored || (c.oversized && id < big)) continue;
+			if (Overlaps(colliders[big], c)) outPairs.push_back(std::make_pair(std::min(big, id), std::max(big, id)));
+		}
+	}
+}
+
+void SpatialHash::QueryOne(const Collider& query, int id, std::vector<int>& outIds) {
+	if (seen[id] == stamp) return;
+	seen[id] = stamp;
+	if (!colliders[id].ignored && Overlaps(query, colliders[id])) outIds.push_back(id);
+}
+
+void SpatialHash::QueryCells(const Collider& query, std::vector<int>& outIds) {
+	Build();
+	if (seen.size() < colliders.size()) seen.resize(colliders.size(), 0);
+	if (++stamp == 0) {
+		std::fill(seen.begin(), seen.end(), 0);
+		stamp = 1;
+	}
+	if (!IsFiniteRec(query.bounds)) return;
+	for (int id : oversized) QueryOne(query, id, outIds);
+
+	int minX = CellOf(query.bounds.x), maxX = CellOf(query.bounds.x + query.bounds.width);
+	int minY = CellOf(query.bounds.y), maxY = CellOf(query.bounds.y + query.bounds.height);
+	if (maxX < minX || maxY < minY) return;
+	// A query covering more cells than there are colliders is quicker
+	// checked against each collider
+	if (((long long)maxX - minX + 1) * ((long long)maxY - minY + 1) > (long long)colliders.size()) {
+		for (int id = 0; id < (int)colliders.size(); id++) QueryOne(query, id, outIds);
+		return;
+	}
+	for (int cy = minY; cy <= maxY; cy++) {
+		for (int cx = minX; cx <= maxX; cx++) {
+			std::pair<size_t, size_t> range = FindCell(cx, cy);
+			for (size_t i = range.first; i < range.second; i++) QueryOne(query, entries[i].id, outIds);
+		}
+	}
+}
+
+void SpatialHash::QueryPoint(Vector2 point, std::vector<int>& outIds) {
+	QueryCircle(point, 0, outIds);
+}
+
+void SpatialHash::QueryRec(Rectangle rec, std::vector<int>& outIds) {
+	Collider q;
+	q.isCircle = false;
+	q.center = Vector2{ 0, 0 };
+	q.radius = 0;
+	q.bounds = rec;
+	QueryCells(q, outIds);
+}
+
+void SpatialHash::QueryCircle(Vector2 center, float radius, std::vector<int>& outIds) {
+	Collider q;
+	q.isCircle = true;
+	q.center = center;
+	q.radius = radius;
+	q.bounds = Rectangle{ center.x - radius, center.y - radius, radius * 2, radius * 2 };
+	QueryCells(q, outIds);
+}
@@ -0,0 +1,72 @@
+//
+// SpatialHash.h
+// MSRLWeb
+//
+// Broad-phase collision index: circles and rectangles are bucketed into a
+// uniform grid of square cells, so overlap and picking queries only test
+// colliders that share a cell.  Meant to be cleared and refilled each frame.
+//
+
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include "raylib.h"
+#include <utility>
+#include <vector>
+
+class SpatialHash {
+public:
+	// cellSize is best a little bigger than a typical collider
+	explicit SpatialHash(float cellSize);
+
+	void Clear();
+
+	// Add a collider; returns its id (ids count up from 0 after each Clear)
+	int AddCircle(Vector2 center, float radius);
+	int AddRec(Rectangle rec);
+
+	int Count() const { return (int)colliders.size(); }
+
+	// Every pair of colliders that overlap (each pair once, lower id first)
+	void FindPairs(std::vector<std::pair<int, int>>& outPairs);
+
+	// Colliders containing point, or overlapping rec or a circle
+	void QueryPoint(Vector2 point, std::vector<int>& outIds);
+	void QueryRec(Rectangle rec, std::vector<int>& outIds);
+	void QueryCircle(Vector2 center, float radius, std::vector<int>& outIds);
+
+private:
+	struct Collider {
+		bool isCircle;
+		Vector2 center;		// circles only
+		float radius;
+		Rectangle bounds;	// the rectangle, or the circle's bounding box
+		int minX, minY, maxX, maxY;		// cells it covers
+		bool oversized;		// too big for the grid; in oversized instead
+		bool ignored;		// not finite, so never overlaps anything
+	};
+
+	struct CellEntry {
+		long long cell;
+		int id;
+	};
+
+	float cellSize;
+	std::vector<Collider> colliders;
+	std::vector<CellEntry> entries;	// sorted by cell (once built)
+	std::vector<int> oversized;		// checked by every query
+	bool built = true;
+	std::vector<unsigned int> seen;	// query stamp per collider, to skip repeats
+	unsigned int stamp = 0;
+
+	int Add(const Collider& c);
+	void Build();
+	int CellOf(float coord) const;
+	// Range of entries in the given cell
+	std::pair<size_t, size_t> FindCell(int cx, int cy) const;
+	bool Overlaps(const Collider& a, const Collider& b) const;
+	void QueryCells(const Collider& query, std::vector<int>& outIds);
+	void QueryOne(const Collider& query, int id, std::vector<int>& outIds);
+};
+
+#endif
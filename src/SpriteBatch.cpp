@@ -0,0 +1,78 @@
+//
+// SpriteBatch.cpp
+// MSRLWeb
+//
+// Drawing many textured quads from one texture in a single pass, straight
+// into rlgl's vertex batch.
+//
+
+#include "SpriteBatch.h"
+#include "rlgl.h"
+#include <math.h>
+
+// Same corner math as raylib's DrawTexturePro (including its handling of
+// negative source sizes for flipping), so a batch looks exactly like the
+// equivalent sequence of DrawTexturePro calls.
+static void EmitSprite(const SpriteInstance& sprite, float texWidth, float texHeight) {
+	Rectangle source = sprite.source;
+	Rectangle dest = sprite.dest;
+	Vector2 origin = sprite.origin;
+
+	bool flipX = false;
+	if (source.width < 0) { flipX = true; source.width = -source.width; }
+	if (source.height < 0) source.y -= source.height;
+	if (dest.width < 0) dest.width = -dest.width;
+	if (dest.height < 0) dest.height = -dest.height;
+
+	Vector2 topLeft, topRight, bottomLeft, bottomRight;
+	if (sprite.rotation == 0.0f) {
+		float x = dest.x - origin.x;
+		float y = dest.y - origin.y;
+		topLeft = Vector2{ x, y };
+		topRight = Vector2{ x + dest.width, y };
+		bottomLeft = Vector2{ x, y + dest.height };
+		bottomRight = Vector2{ x + dest.width, y + dest.height };
+	} else {
+		float s = sinf(sprite.rotation * DEG2RAD);
+		float c = cosf(sprite.rotation * DEG2RAD);
+		float dx = -origin.x;
+		float dy = -origin.y;
+		topLeft = Vector2{ dest.x + dx*c - dy*s, dest.y + dx*s + dy*c };
+		topRight = Vector2{ dest.x + (dx + dest.width)*c - dy*s, dest.y + (dx + dest.width)*s + dy*c };
+		bottomLeft = Vector2{ dest.x + dx*c - (dy + dest.height)*s, dest.y + dx*s + (dy + dest.height)*c };
+		bottomRight = Vector2{ dest.x + (dx + dest.width)*c - (dy + dest.height)*s,
+			dest.y + (dx + dest.width)*s + (dy + dest.height)*c };
+	}
+
+	float u0 = source.x / texWidth;
+	float u1 = (source.x + source.width) / texWidth;
+	float v0 = source.y / texHeight;
+	float v1 = (source.y + source.height) / texHeight;
+	if (flipX) { float t = u0; u0 = u1; u1 = t; }
+
+	// Flushes (and resumes) the batch if these 4 vertices won't fit
+	rlCheckRenderBatchLimit(4);
+
+	rlColor4ub(sprite.tint.r, sprite.tint.g, sprite.tint.b, sprite.tint.a);
+	rlNormal3f(0.0f, 0.0f, 1.0f);
+	rlTexCoord2f(u0, v0);
+	rlVertex2f(topLeft.x, topLeft.y);
+	rlTexCoord2f(u0, v1);
+	rlVertex2f(bottomLeft.x, bottomLeft.y);
+	rlTexCoord2f(u1, v1);
+	rlVertex2f(bottomRight.x, bottomRight.y);
+	rlTexCoord2f(u1, v0);
+	rlVertex2f(topRight.x, topRight.y);
+}
+
+void DrawSpriteBatch(Texture2D texture, const SpriteInstance *sprites, int count) {
+	if (texture.id == 0 || count <= 0) return;
+	float texWidth = (float)texture.width;
+	float texHeight = (float)texture.height;
+
+	rlSetTexture(texture.id);
+	rlBegin(RL_QUADS);
+	for (int i = 0; i < count; i++) EmitSprite(sprites[i], texWidth, texHeight);
+	rlEnd();
+	rlSetTexture(0);
+}
@@ -0,0 +1,32 @@
+//
+// SpriteBatch.h
+// MSRLWeb
+//
+// Drawing many textured quads from one texture in a single pass, straight
+// into rlgl's vertex batch.
+//
+
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include "raylib.h"
+
+// One sprite: the same parameters DrawTexturePro takes
+struct SpriteInstance {
+	Rectangle source;
+	Rectangle dest;
+	Vector2 origin;
+	float rotation;		// degrees
+	Color tint;
+};
+
+// Number of floats per sprite in a packed instance buffer:
+//   srcX, srcY, srcW, srcH, destX, destY, destW, destH, originX, originY,
+//   rotation, tint (a packed 0xRRGGBBAA color)
+static const int kSpriteInstanceStride = 12;
+
+// Draw count sprites from texture; equivalent to calling DrawTexturePro on
+// each one in turn, but without switching texture or draw mode in between.
+void DrawSpriteBatch(Texture2D texture, const SpriteInstance *sprites, int count);
+
+#endif
@@ -0,0 +1,135 @@
+//
+// SpriteLayer.cpp
+// MSRLWeb
+//
+// A native collection of sprites, stored as parallel arrays so that drawing
+// (and bulk updates) run as tight loops over contiguous data.  The layer
+// draws its sprites grouped by texture, each group as one SpriteBatch.
+//
+
+#include "SpriteLayer.h"
+#include <algorithm>
+
+int SpriteLayer::Add(Texture2D tex, MiniScript::Value spriteOwner) {
+	int id;
+	if (!freeIds.empty()) {
+		id = freeIds.back();
+		freeIds.pop_back();
+	} else {
+		id = (int)indexOfId.size();
+		indexOfId.push_back(-1);
+	}
+	indexOfId[id] = (int)x.size();
+	ids.push_back(id);
+	x.push_back(0);
+	y.push_back(0);
+	rotation.push_back(0);
+	scale.push_back(1);
+	tint.push_back(WHITE);
+	texture.push_back(tex);
+	source.push_back(Rectangle{0, 0, 0, 0});
+	owner.push_back(spriteOwner);
+	orderDirty = true;
+	return id;
+}
+
+bool SpriteLayer::Remove(int id) {
+	int index = IndexOf(id);
+	if (index < 0) return false;
+	RemoveAt(index);
+	return true;
+}
+
+void SpriteLayer::RemoveAt(int index) {
+	int id = ids[index];
+
+	// Move the last sprite into the hole
+	int last = (int)x.size() - 1;
+	if (index != last) {
+		x[index] = x[last];
+		y[index] = y[last];
+		rotation[index] = rotation[last];
+		scale[index] = scale[last];
+		tint[index] = tint[last];
+		texture[index] = texture[last];
+		source[index] = source[last];
+		owner[index] = owner[last];
+		ids[index] = ids[last];
+		indexOfId[ids[index]] = index;
+	}
+	x.pop_back();
+	y.pop_back();
+	rotation.pop_back();
+	scale.pop_back();
+	tint.pop_back();
+	texture.pop_back();
+	source.pop_back();
+	owner.pop_back();
+	ids.pop_back();
+
+	indexOfId[id] = -1;
+	freeIds.push_back(id);
+	orderDirty = true;
+}
+
+void SpriteLayer::Clear() {
+	x.clear();
+	y.clear();
+	rotation.clear();
+	scale.clear();
+	tint.clear();
+	texture.clear();
+	source.clear();
+	owner.clear();
+	ids.clear();
+	indexOfId.clear();
+	freeIds.clear();
+	order.clear();
+	orderDirty = false;
+}
+
+void SpriteLayer::SetTexture(int index, Texture2D tex) {
+	if (texture[index].id != tex.id) orderDirty = true;
+	texture[index] = tex;
+}
+
+void SpriteLayer::Draw() {
+	int count = Count();
+	if (count == 0) return;
+
+	// Sprites sharing a texture go together; within a texture, they keep
+	// the order they're stored in.  Only re-sort when that could change.
+	if (orderDirty || (int)order.size() != count) {
+		order.resize(count);
+		for (int i = 0; i < count; i++) order[i] = i;
+		std::stable_sort(order.begin(), order.end(),
+			[this](int a, int b) { return texture[a].id < texture[b].id; });
+		orderDirty = false;
+	}
+
+	instances.resize(count);
+	for (int k = 0; k < count; k++) {
+		int i = order[k];
+		Rectangle src = source[i];
+		if (src.width == 0 || src.height == 0) {
+			src = Rectangle{0, 0, (float)texture[i].width, (float)texture[i].height};
+		}
+		float w = (src.width < 0 ? -src.width : src.width) * scale[i];
+		float h = (src.height < 0 ? -src.height : src.height) * scale[i];
+		SpriteInstance& inst = instances[k];
+		inst.source = src;
+		inst.dest = Rectangle{x[i], y[i], w, h};
+		inst.origin = Vector2{w * 0.5f, h * 0.5f};
+		inst.rotation = rotation[i];
+		inst.tint = tint[i];
+	}
+
+	// One batch per run of the same texture
+	int runStart = 0;
+	for (int k = 1; k <= count; k++) {
+		if (k == count || texture[order[k]].id != texture[order[runStart]].id) {
+			DrawSpriteBatch(texture[order[runStart]], &instances[runStart], k - runStart);
+			runStart = k;
+		}
+	}
+}
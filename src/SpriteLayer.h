@@ -0,0 +1,65 @@
+//
+// SpriteLayer.h
+// MSRLWeb
+//
+// A native collection of sprites, stored as parallel arrays so that drawing
+// (and bulk updates) run as tight loops over contiguous data.  The layer
+// draws its sprites grouped by texture, each group as one SpriteBatch.
+//
+
+#ifndef SPRITELAYER_H
+#define SPRITELAYER_H
+
+#include "SpriteBatch.h"
+#include "MiniscriptTypes.h"
+#include <vector>
+
+class SpriteLayer {
+public:
+	// One element per sprite, densely packed by index.  Indexes are not
+	// stable (removing a sprite moves the last one into its place); refer
+	// to a sprite over time by the id Add returns, via IndexOf.
+	std::vector<float> x, y;
+	std::vector<float> rotation;	// degrees
+	std::vector<float> scale;
+	std::vector<Color> tint;
+	std::vector<Texture2D> texture;
+	std::vector<Rectangle> source;	// 0 width or height: the whole texture
+	std::vector<MiniScript::Value> owner;	// kept alive as long as its sprite
+											// (and with it, the texture)
+
+	// Add a sprite showing all of texture at (0, 0); returns its id
+	int Add(Texture2D tex, MiniScript::Value spriteOwner = MiniScript::Value::null);
+
+	// Remove a sprite by id; false if there's no such sprite
+	bool Remove(int id);
+
+	// Remove the sprite at an index (moving the last one into its place)
+	void RemoveAt(int index);
+
+	void Clear();
+
+	int Count() const { return (int)x.size(); }
+
+	// Index of the sprite with the given id, or -1
+	int IndexOf(int id) const {
+		return (id >= 0 && id < (int)indexOfId.size()) ? indexOfId[id] : -1;
+	}
+
+	// Change a sprite's texture (use this rather than assigning to texture[],
+	// so the draw order gets updated)
+	void SetTexture(int index, Texture2D tex);
+
+	// Draw every sprite, centered on its position, grouped by texture
+	void Draw();
+
+private:
+	std::vector<int> ids;			// index -> id
+	std::vector<int> indexOfId;		// id -> index, or -1 if free
+	std::vector<int> freeIds;
+	std::vector<int> order;			// indexes, sorted by texture
+	bool orderDirty = false;
+	std::vector<SpriteInstance> instances;	// scratch space for Draw
+};
+
+#endif
@@ -0,0 +1,140 @@
+//
+// TextCache.cpp
+// MSRLWeb
+//
+// Laid-out text: the glyph quads for a string in a given font, size and
+// spacing, computed once and then drawn as a single SpriteBatch.  Recently
+// used layouts are kept in an LRU cache, so text that's drawn every frame
+// (HUDs, menus) is decoded and laid out only the first time.
+//
+
+#include "TextCache.h"
+#include <string.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+struct CachedLayout {
+	std::string key;
+	TextLayout layout;
+};
+
+static std::list<CachedLayout> lru;		// most recently used first
+static std::unordered_map<std::string, std::list<CachedLayout>::iterator> layoutIndex;
+static size_t maxLayouts = 256;
+static TextCacheStats stats = { 0, 0, 0, 0 };
+
+void LayoutText(TextLayout& layout, Font font, const char *text, float fontSize, float spacing) {
+	if (font.texture.id == 0) font = GetFontDefault();
+	layout.texture = font.texture;
+	layout.glyphs.clear();
+	layout.size = MeasureTextEx(font, text, fontSize, spacing);
+	if (font.baseSize == 0) return;
+
+	// raylib keeps its line spacing to itself, but MeasureTextEx adds
+	// fontSize plus that spacing for each newline
+	float lineAdvance = MeasureTextEx(font, "\n", fontSize, 0).y - fontSize;
+
+	// Same walk as DrawTextEx, with DrawTextCodepoint's glyph placement
+	float scale = fontSize / font.baseSize;
+	float pad = (float)font.glyphPadding;
+	float offsetX = 0, offsetY = 0;
+	int length = (int)strlen(text);
+	for (int i = 0; i < length;) {
+		int byteCount = 0;
+		int codepoint = GetCodepointNext(&text[i], &byteCount);
+		int g = GetGlyphIndex(font, codepoint);
+		i += byteCount > 0 ? byteCount : 1;
+
+		if (codepoint == '\n') {
+			offsetY += lineAdvance;
+			offsetX = 0;
+			continue;
+		}
+		Rectangle rec = font.recs[g];
+		if (codepoint != ' ' && codepoint != '\t') {
+			SpriteInstance glyph;
+			glyph.source = Rectangle{ rec.x - pad, rec.y - pad, rec.width + 2 * pad, rec.height + 2 * pad };
+			glyph.dest = Rectangle{ offsetX + font.glyphs[g].offsetX * scale - pad * scale,
+				offsetY + font.glyphs[g].offsetY * scale - pad * scale,
+				(rec.width + 2 * pad) * scale, (rec.height + 2 * pad) * scale };
+			glyph.origin = Vector2{ 0, 0 };
+			glyph.rotation = 0;
+			glyph.tint = WHITE;
+			layout.glyphs.push_back(glyph);
+		}
+		if (font.glyphs[g].advanceX == 0) offsetX += rec.width * scale + spacing;
+		else offsetX += font.glyphs[g].advanceX * scale + spacing;
+	}
+}
+
+static std::string LayoutKey(Font font, const char *text, float fontSize, float spacing) {
+	// The font is identified by its texture and glyph table
+	std::string key;
+	key.append((const char*)&font.texture.id, sizeof(font.texture.id));
+	key.append((const char*)&font.glyphs, sizeof(font.glyphs));
+	key.append((const char*)&fontSize, sizeof(fontSize));
+	key.append((const char*)&spacing, sizeof(spacing));
+	key += text;
+	return key;
+}
+
+const TextLayout& GetTextLayout(Font font, const char *text, float fontSize, float spacing) {
+	if (font.texture.id == 0) font = GetFontDefault();
+	std::string key = LayoutKey(font, text, fontSize, spacing);
+	auto it = layoutIndex.find(key);
+	if (it != layoutIndex.end()) {
+		stats.hits++;
+		lru.splice(lru.begin(), lru, it->second);
+		return it->second->layout;
+	}
+
+	stats.misses++;
+	while (!lru.empty() && lru.size() >= maxLayouts) {
+		layoutIndex.erase(lru.back().key);
+		lru.pop_back();
+		stats.evictions++;
+	}
+	lru.push_front(CachedLayout{ key, TextLayout() });
+	LayoutText(lru.front().layout, font, text, fontSize, spacing);
+	layoutIndex[key] = lru.begin();
+	stats.entries = (long)lru.size();
+	return lru.front().layout;
+}
+
+void DrawTextLayout(const TextLayout& layout, Vector2 position, Color tint) {
+	static std::vector<SpriteInstance> glyphs;
+	glyphs.assign(layout.glyphs.begin(), layout.glyphs.end());
+	for (SpriteInstance& glyph : glyphs) {
+		glyph.dest.x += position.x;
+		glyph.dest.y += position.y;
+		glyph.tint = tint;
+	}
+	DrawSpriteBatch(layout.texture, glyphs.data(), (int)glyphs.size());
+}
+
+void ForgetTextLayouts(Font font) {
+	for (auto it = lru.begin(); it != lru.end();) {
+		if (it->layout.texture.id == font.texture.id) {
+			layoutIndex.erase(it->key);
+			it = lru.erase(it);
+		} else {
+			++it;
+		}
+	}
+	stats.entries = (long)lru.size();
+}
+
+void SetTextCacheCapacity(int entries) {
+	maxLayouts = entries > 0 ? (size_t)entries : 1;
+	while (lru.size() > maxLayouts) {
+		layoutIndex.erase(lru.back().key);
+		lru.pop_back();
+		stats.evictions++;
+	}
+	stats.entries = (long)lru.size();
+}
+
+TextCacheStats GetTextCacheStats() {
+	return stats;
+}
@@ -0,0 +1,49 @@
+//
+// TextCache.h
+// MSRLWeb
+//
+// Laid-out text: the glyph quads for a string in a given font, size and
+// spacing, computed once and then drawn as a single SpriteBatch.  Recently
+// used layouts are kept in an LRU cache, so text that's drawn every frame
+// (HUDs, menus) is decoded and laid out only the first time.
+//
+
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include "SpriteBatch.h"
+#include <vector>
+
+struct TextLayout {
+	Texture2D texture;					// the font's
+	std::vector<SpriteInstance> glyphs;	// relative to the text's top left
+	Vector2 size;						// as MeasureTextEx would give
+};
+
+// Lay out text the way DrawTextEx draws it (a font with no texture means
+// the default font), without caching
+void LayoutText(TextLayout& layout, Font font, const char *text, float fontSize, float spacing);
+
+// The layout for text, from the cache if it's there.  The result is only
+// good until the next call (which may evict it).
+const TextLayout& GetTextLayout(Font font, const char *text, float fontSize, float spacing);
+
+// Draw a layout with its top left at position
+void DrawTextLayout(const TextLayout& layout, Vector2 position, Color tint);
+
+// Drop any cached layouts using font (call before unloading it)
+void ForgetTextLayouts(Font font);
+
+// Maximum number of cached layouts
+void SetTextCacheCapacity(int entries);
+
+struct TextCacheStats {
+	long hits;
+	long misses;
+	long evictions;		// layouts dropped to stay under the capacity
+	long entries;
+};
+
+TextCacheStats GetTextCacheStats();
+
+#endif
@@ -0,0 +1,194 @@
+//
+// TileMap.cpp
+// MSRLWeb
+//
+// A grid of tile indexes drawn from a tileset texture.  The map is split into
+// square chunks, each rendered once into its own render texture and then
+// drawn as a single quad; a chunk is re-rendered only when one of its tiles
+// changes, and only chunks that are on screen are drawn (or kept in memory).
+//
+
+#include "TileMap.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include <math.h>
+
+TileMap::TileMap(Texture2D tileset, int tileWidth, int tileHeight, int width, int height,
+				 int chunkSize, int maxChunks)
+	: tileset(tileset),
+	  tileWidth(tileWidth > 0 ? tileWidth : 1), tileHeight(tileHeight > 0 ? tileHeight : 1),
+	  width(width > 0 ? width : 0), height(height > 0 ? height : 0),
+	  chunkSize(chunkSize > 0 ? chunkSize : 16), maxChunks(maxChunks > 0 ? maxChunks : 1) {
+	chunksAcross = (this->width + this->chunkSize - 1) / this->chunkSize;
+	chunksDown = (this->height + this->chunkSize - 1) / this->chunkSize;
+	tiles.assign((size_t)this->width * this->height, -1);
+	chunks.assign((size_t)chunksAcross * chunksDown, Chunk{ RenderTexture2D{}, true, 0 });
+}
+
+TileMap::~TileMap() {
+	for (Chunk& chunk : chunks) FreeChunk(chunk);
+}
+
+int TileMap::GetTile(int x, int y) const {
+	if (x < 0 || y < 0 || x >= width || y >= height) return -1;
+	return tiles[(size_t)y * width + x];
+}
+
+void TileMap::SetTile(int x, int y, int tile) {
+	if (x < 0 || y < 0 || x >= width || y >= height) return;
+	int& cell = tiles[(size_t)y * width + x];
+	if (cell == tile) return;
+	cell = tile;
+	ChunkAt(x / chunkSize, y / chunkSize).dirty = true;
+}
+
+void TileMap::SetTileset(Texture2D texture) {
+	tileset = texture;
+	for (Chunk& chunk : chunks) chunk.dirty = true;
+}
+
+size_t TileMap::ChunkBytes() const {
+	size_t chunkPixels = (size_t)chunkSize * tileWidth * chunkSize * tileHeight;
+	return (size_t)liveChunks * chunkPixels * 4;
+}
+
+void TileMap::FreeChunk(Chunk& chunk) {
+	if (chunk.target.id == 0) return;
+	UnloadRenderTexture(chunk.target);
+	chunk.target = RenderTexture2D{};
+	chunk.dirty = true;
+	liveChunks--;
+}
+
+void TileMap::EvictOldestChunk() {
+	Chunk *oldest = nullptr;
+	for (Chunk& chunk : chunks) {
+		if (chunk.target.id && (!oldest || chunk.lastDrawn < oldest->lastDrawn)) oldest = &chunk;
+	}
+	// Never free one that's on screen now; go over the limit instead
+	if (oldest && oldest->lastDrawn < drawCount) FreeChunk(*oldest);
+}
+
+// Draw a chunk's tiles individually, with its top-left corner at position
+void TileMap::DrawChunkTiles(int cx, int cy, Vector2 position, Color tint) {
+	int columns = tileset.width / tileWidth;
+	int rows = tileset.height / tileHeight;
+	if (columns <= 0) return;
+	int x0 = cx * chunkSize, y0 = cy * chunkSize;
+	int x1 = x0 + chunkSize < width ? x0 + chunkSize : width;
+	int y1 = y0 + chunkSize < height ? y0 + chunkSize : height;
+	for (int y = y0; y < y1; y++) {
+		for (int x = x0; x < x1; x++) {
+			int tile = tiles[(size_t)y * width + x];
+			if (tile < 0 || tile >= columns * rows) continue;
+			Rectangle src = { (float)((tile % columns) * tileWidth), (float)((tile / columns) * tileHeight),
+				(float)tileWidth, (float)tileHeight };
+			Vector2 pos = { position.x + (x - x0) * tileWidth, position.y + (y - y0) * tileHeight };
+			DrawTextureRec(tileset, src, pos, tint);
+		}
+	}
+}
+
+void TileMap::RenderChunk(int cx, int cy) {
+	Chunk& chunk = ChunkAt(cx, cy);
+	if (chunk.target.id == 0) {
+		if (liveChunks >= maxChunks) EvictOldestChunk();
+		chunk.target = LoadRenderTexture(chunkSize * tileWidth, chunkSize * tileHeight);
+		if (chunk.target.id == 0) return;
+		liveChunks++;
+	}
+
+	BeginTextureMode(chunk.target);
+	ClearBackground(BLANK);
+	DrawChunkTiles(cx, cy, Vector2{ 0, 0 }, WHITE);
+	EndTextureMode();
+	chunk.dirty = false;
+}
+
+// The chunk (in a row or column of count) containing coord, as an int only
+// once it's within [-1, count], since coord may be huge or NaN
+static int ChunkIndex(float coord, float chunkSize, int count) {
+	float c = floorf(coord / chunkSize);
+	if (!(c >= -1)) return -1;		// also catches NaN
+	if (c > count) return count;
+	return (int)c;
+}
+
+static bool IsIdentity(const Matrix& m) {
+	return m.m0 == 1 && m.m5 == 1 && m.m10 == 1 && m.m15 == 1
+		&& m.m1 == 0 && m.m2 == 0 && m.m3 == 0 && m.m4 == 0 && m.m6 == 0 && m.m7 == 0
+		&& m.m8 == 0 && m.m9 == 0 && m.m11 == 0 && m.m12 == 0 && m.m13 == 0 && m.m14 == 0;
+}
+
+void TileMap::Draw(Vector2 position, Color tint) {
+	if (chunksAcross == 0 || chunksDown == 0) return;
+	drawCount++;
+
+	// Just the chunks overlapping the render target, as seen through the
+	// current transform (e.g. a Camera2D): map its corners back into the
+	// coordinates we draw in, and take their bounds
+	Matrix modelview = rlGetMatrixModelview();
+	bool transformed = !IsIdentity(modelview);
+	// Switching render targets resets the transform, and leaves any render
+	// texture we're drawing into (e.g. a screen layer)
+	bool canRender = !transformed && rlGetActiveFramebuffer() == 0;
+	Matrix inverse = MatrixInvert(modelview);
+	float targetW = (float)rlGetFramebufferWidth(), targetH = (float)rlGetFramebufferHeight();
+	Vector2 corners[4] = { { 0, 0 }, { targetW, 0 }, { 0, targetH }, { targetW, targetH } };
+	float left = INFINITY, top = INFINITY, right = -INFINITY, bottom = -INFINITY;
+	for (Vector2 corner : corners) {
+		Vector2 p = transformed ? Vector2Transform(corner, inverse) : corner;
+		left = fminf(left, p.x);
+		top = fminf(top, p.y);
+		right = fmaxf(right, p.x);
+		bottom = fmaxf(bottom, p.y);
+	}
+
+	float chunkW = (float)(chunkSize * tileWidth);
+	float chunkH = (float)(chunkSize * tileHeight);
+	int minX = ChunkIndex(left - position.x, chunkW, chunksAcross);
+	int minY = ChunkIndex(top - position.y, chunkH, chunksDown);
+	int maxX = ChunkIndex(right - position.x, chunkW, chunksAcross);
+	int maxY = ChunkIndex(bottom - position.y, chunkH, chunksDown);
+	if (minX < 0) minX = 0;
+	if (minY < 0) minY = 0;
+	if (maxX >= chunksAcross) maxX = chunksAcross - 1;
+	if (maxY >= chunksDown) maxY = chunksDown - 1;
+	visMinX = minX;
+	visMinY = minY;
+	visMaxX = maxX;
+	visMaxY = maxY;
+
+	// Render what's stale first, so we switch render targets only up front
+	// (or, if we can't switch now, leave it to Update)
+	for (int cy = minY; cy <= maxY; cy++) {
+		for (int cx = minX; cx <= maxX; cx++) {
+			Chunk& chunk = ChunkAt(cx, cy);
+			chunk.lastDrawn = drawCount;
+			if (canRender && (chunk.dirty || chunk.target.id == 0)) RenderChunk(cx, cy);
+		}
+	}
+
+	for (int cy = minY; cy <= maxY; cy++) {
+		for (int cx = minX; cx <= maxX; cx++) {
+			Chunk& chunk = ChunkAt(cx, cy);
+			Vector2 pos = { position.x + cx * chunkW, position.y + cy * chunkH };
+			if (chunk.dirty || chunk.target.id == 0) {
+				DrawChunkTiles(cx, cy, pos, tint);
+				continue;
+			}
+			// Render textures are stored upside down, hence the negative height
+			Rectangle src = { 0, 0, (float)chunk.target.texture.width, -(float)chunk.target.texture.height };
+			DrawTextureRec(chunk.target.texture, src, pos, tint);
+		}
+	}
+}
+
+void TileMap::Update() {
+	for (int cy = visMinY; cy <= visMaxY; cy++) {
+		for (int cx = visMinX; cx <= visMaxX; cx++) {
+			Chunk& chunk = ChunkAt(cx, cy);
+			if (chunk.dirty || chunk.target.id == 0) RenderChunk(cx, cy);
+		}
+	}
+}
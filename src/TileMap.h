@@ -0,0 +1,77 @@
+//
+// TileMap.h
+// MSRLWeb
+//
+// A grid of tile indexes drawn from a tileset texture.  The map is split into
+// square chunks, each rendered once into its own render texture and then
+// drawn as a single quad; a chunk is re-rendered only when one of its tiles
+// changes, and only chunks that are on screen are drawn (or kept in memory).
+//
+
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include "raylib.h"
+#include <vector>
+
+class TileMap {
+public:
+	// width and height are in tiles; chunkSize is the number of tiles along
+	// each side of a chunk.  At most maxChunks chunk textures are kept; the
+	// ones drawn least recently are freed first (and re-rendered if needed).
+	TileMap(Texture2D tileset, int tileWidth, int tileHeight, int width, int height,
+			int chunkSize = 16, int maxChunks = 64);
+	~TileMap();
+
+	int Width() const { return width; }
+	int Height() const { return height; }
+
+	// Tile indexes count across the tileset's rows, from its top left; a
+	// negative index is an empty cell.  Out-of-range cells read as -1.
+	int GetTile(int x, int y) const;
+	void SetTile(int x, int y, int tile);
+
+	void SetTileset(Texture2D texture);
+
+	// Draw the map with its top-left corner at position.  Only the chunks
+	// visible through the current transform (e.g. a Camera2D) are drawn.
+	// Chunks that need (re-)rendering are rendered here only when drawing
+	// straight to the screen with no transform, since that switches render
+	// targets; otherwise their tiles are drawn one by one this frame, and
+	// Update renders them.
+	void Draw(Vector2 position, Color tint);
+
+	// Render the chunks the last Draw needed but couldn't render.  Call it
+	// outside of any transform or BeginTextureMode.
+	void Update();
+
+	// Memory used by chunk textures
+	size_t ChunkBytes() const;
+
+private:
+	struct Chunk {
+		RenderTexture2D target;		// id 0 if not allocated
+		bool dirty;
+		unsigned long lastDrawn;
+	};
+
+	Texture2D tileset;
+	int tileWidth, tileHeight;
+	int width, height;
+	int chunkSize, chunksAcross, chunksDown;
+	int maxChunks;
+	int liveChunks = 0;
+	unsigned long drawCount = 0;
+	std::vector<int> tiles;
+	std::vector<Chunk> chunks;
+
+	int visMinX = 0, visMinY = 0, visMaxX = -1, visMaxY = -1;	// chunks, as of the last Draw
+
+	Chunk& ChunkAt(int cx, int cy) { return chunks[cy * chunksAcross + cx]; }
+	void FreeChunk(Chunk& chunk);
+	void EvictOldestChunk();
+	void RenderChunk(int cx, int cy);
+	void DrawChunkTiles(int cx, int cy, Vector2 position, Color tint);
+};
+
+#endif
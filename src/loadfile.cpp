@@ -2,32 +2,37 @@
 // loadfile.cpp
 // MSRLWeb
 //
-// raylib LoadFileData/LoadFileText hooks
+// raylib LoadFileData/LoadFileText hooks, and asset pack loading
 //
 
 #include "loadfile.h"
+#include "AssetPack.h"
 #include "raylib.h"
 #include <emscripten.h>
-#include <emscripten/fetch.h>
+#include "AssetCache.h"
 #include <cstring>
+#include <stdlib.h>
 #include <stdio.h>
 
+#ifndef MSRLWEB_NO_ASYNCIFY
+
+// With ASYNCIFY (or JSPI), the program suspends while the file downloads
+
 EM_ASYNC_JS(unsigned char*, fetchData, (const char *_url, int *_size), {
 	const url = UTF8ToString(_url);
 	Module.print(`LoadFileData: Fetching ${url} as data...`);
-	return await fetch(url).then(async (response)=>{
-		if (response.status!==200) {
-			Module.print(`LoadFileData: Failed loading ${url} (${response.status} ${response.statusText})`);
+	return await Module.assetCache.fetch(url).then((result)=>{
+		if (result.status!==200) {
+			Module.print(`LoadFileData: Failed loading ${url} (${result.status})`);
 			return 0; // nullptr
 		}
-		const buffer = await response.arrayBuffer();
-		let size = buffer.byteLength;
+		let size = result.bytes.length;
 		Module.print(`LoadFileData: Successfully loaded ${size} byte(s)`);
 		// set the size variable
 		(new Int32Array(HEAP8.buffer, _size))[0] = size;
 		// allocate a buffer and copy the response into it
 		let ptr = Module._malloc(size);
-		(new Uint8Array(HEAP8.buffer, ptr, size)).set(new Uint8Array(buffer, 0, size));
+		(new Uint8Array(HEAP8.buffer, ptr, size)).set(result.bytes);
 		return ptr;
 	});
 });
@@ -35,12 +40,12 @@ EM_ASYNC_JS(unsigned char*, fetchData, (const char *_url, int *_size), {
 EM_ASYNC_JS(char*, fetchText, (const char *_url), {
 	const url = UTF8ToString(_url);
 	Module.print(`LoadFileText: Fetching ${url} as text...`);
-	return await fetch(url).then(async (response)=>{
-		if (response.status!==200) {
-			Module.print(`LoadFileText: Failed loading ${url} (${response.status} ${response.statusText})`);
+	return await Module.assetCache.fetch(url).then((result)=>{
+		if (result.status!==200) {
+			Module.print(`LoadFileText: Failed loading ${url} (${result.status})`);
 			return 0; // nullptr
 		}
-		const text = await response.text();
+		const text = new TextDecoder().decode(result.bytes);
 		let size = lengthBytesUTF8(text)+1; // null terminator
 		Module.print(`LoadFileText: Successfully loaded ${text.length} character(s) (${size} byte(s))`);
 		// allocate a buffer and copy the response into it
@@ -50,7 +55,122 @@ EM_ASYNC_JS(char*, fetchText, (const char *_url), {
 	});
 });
 
+#else
+
+// Without ASYNCIFY we can't suspend, so fall back to a synchronous request.
+// That blocks the browser, but these hooks only serve raylib's own file
+// loads; our loader intrinsics fetch without blocking (see LoadAssetIntrinsic).
+
+EM_JS(unsigned char*, fetchData, (const char *_url, int *_size), {
+	const url = UTF8ToString(_url);
+	Module.print(`LoadFileData: Fetching ${url} synchronously...`);
+	const xhr = new XMLHttpRequest();
+	xhr.open('GET', url, false);
+	// Synchronous requests can't use responseType, so get the bytes as a binary string
+	xhr.overrideMimeType('text/plain; charset=x-user-defined');
+	try { xhr.send(null); } catch (e) { return 0; }
+	if (xhr.status!==200) {
+		Module.print(`LoadFileData: Failed loading ${url} (${xhr.status})`);
+		return 0; // nullptr
+	}
+	const text = xhr.responseText;
+	let size = text.length;
+	(new Int32Array(HEAP8.buffer, _size))[0] = size;
+	let ptr = Module._malloc(size);
+	const bytes = new Uint8Array(HEAP8.buffer, ptr, size);
+	for (let i = 0; i < size; i++) bytes[i] = text.charCodeAt(i) & 0xFF;
+	return ptr;
+});
+
+EM_JS(char*, fetchText, (const char *_url), {
+	const url = UTF8ToString(_url);
+	Module.print(`LoadFileText: Fetching ${url} synchronously...`);
+	const xhr = new XMLHttpRequest();
+	xhr.open('GET', url, false);
+	try { xhr.send(null); } catch (e) { return 0; }
+	if (xhr.status!==200) {
+		Module.print(`LoadFileText: Failed loading ${url} (${xhr.status})`);
+		return 0; // nullptr
+	}
+	const text = xhr.responseText;
+	let size = lengthBytesUTF8(text)+1; // null terminator
+	let ptr = Module._malloc(size);
+	stringToUTF8(text, ptr, size);
+	return ptr;
+});
+
+#endif
+
+// raylib frees what these return, so even packed files must be copied here;
+// our own loaders use FindPackedAsset directly to avoid that.
+static unsigned char* loadFileData(const char *fileName, int *dataSize) {
+	const unsigned char *packed;
+	int size;
+	if (FindPackedAsset(fileName, &packed, &size)) {
+		unsigned char *data = (unsigned char*)malloc(size > 0 ? size : 1);
+		if (!data) return nullptr;
+		memcpy(data, packed, size);
+		*dataSize = size;
+		return data;
+	}
+	return fetchData(fileName, dataSize);
+}
+
+static char* loadFileText(const char *fileName) {
+	const unsigned char *packed;
+	int size;
+	if (FindPackedAsset(fileName, &packed, &size)) {
+		char *text = (char*)malloc(size + 1);
+		if (!text) return nullptr;
+		memcpy(text, packed, size);
+		text[size] = '\0';
+		return text;
+	}
+	return fetchText(fileName);
+}
+
 void InstallLoadFileHooks() {
-	SetLoadFileDataCallback(fetchData);
-	SetLoadFileTextCallback(fetchText);
+	SetLoadFileDataCallback(loadFileData);
+	SetLoadFileTextCallback(loadFileText);
+}
+
+//--------------------------------------------------------------------------------
+// Asset pack loading
+//--------------------------------------------------------------------------------
+
+static bool packLoading = false;
+static double packProgress = 0;
+
+static void onPackProgress(AssetFetch *fetch) {
+	if (fetch->totalBytes > 0) packProgress = fetch->loadedBytes / fetch->totalBytes;
+}
+
+static void onPackFetched(AssetFetch *fetch) {
+	packLoading = false;
+	packProgress = 1;
+	if (fetch->status == 200
+			&& MountAssetPack((const unsigned char*)fetch->data, (long)fetch->numBytes)) {
+		// Packed files are served straight out of the download, so we keep
+		// the fetch (and its data) open for the life of the program.
+		printf("Loaded asset pack %s (%d files, %llu bytes)\n",
+			fetch->url, GetPackedAssetCount(), fetch->numBytes);
+		return;
+	}
+	// A missing pack is normal (e.g. during development); assets are then
+	// fetched individually.
+	CloseAssetFetch(fetch);
+}
+
+void FetchAssetPack(const char *url) {
+	packLoading = true;
+	packProgress = 0;
+	FetchAsset(url, onPackFetched, nullptr, onPackProgress);
+}
+
+bool IsAssetPackLoading() {
+	return packLoading;
+}
+
+double GetAssetPackProgress() {
+	return packProgress;
 }
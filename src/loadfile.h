@@ -2,13 +2,21 @@
 // loadfile.h
 // MSRLWeb
 //
-// raylib LoadFileData/LoadFileText hooks
+// raylib LoadFileData/LoadFileText hooks, and asset pack loading
 //
 
 #ifndef LOADFILE_H
 #define LOADFILE_H
 
-// Install LoadFileData/LoadFileText callbacks
+// Install LoadFileData/LoadFileText callbacks.  These serve files from the
+// asset pack when there is one, and fetch them individually otherwise.
 void InstallLoadFileHooks();
 
+// Start fetching the asset pack (see AssetPack.h)
+void FetchAssetPack(const char *url);
+
+// Whether the asset pack is still downloading, and how far along it is (0-1)
+bool IsAssetPackLoading();
+double GetAssetPackProgress();
+
 #endif
@@ -7,9 +7,12 @@
 #include "MiniscriptIntrinsics.h"
 #include "MiniscriptParser.h"
 #include "RaylibIntrinsics.h"
+#include "FrameScheduler.h"
+#include "ScriptBundle.h"
 #include "loadfile.h"
 #include <emscripten/emscripten.h>
-#include <emscripten/fetch.h>
+#include "AssetCache.h"
+#include "DecodePool.h"
 #include <stdio.h>
 
 using namespace MiniScript;
@@ -28,6 +31,7 @@ enum ScriptState {
 static Interpreter* interpreter = nullptr;
 static ScriptState scriptState = LOADING;
 static String scriptSource;
+static bool scriptFetchDone = false;
 static String loadError;
 static String runtimeError;
 static ValueList stackTrace;
@@ -49,10 +53,10 @@ static void PrintErr(String s, bool lineBreak = true) {
 }
 
 //--------------------------------------------------------------------------------
-// Script loading via Emscripten fetch
+// Script loading (through the asset cache)
 //--------------------------------------------------------------------------------
 
-void onScriptFetched(emscripten_fetch_t *fetch) {
+void onScriptFetched(AssetFetch *fetch) {
 	if (fetch->status == 200) {
 		printf("Downloaded %llu bytes from URL %s\n", fetch->numBytes, fetch->url);
 
@@ -67,29 +71,295 @@ void onScriptFetched(emscripten_fetch_t *fetch) {
 			// State remains LOADING until RunScript is called
 		} else {
 			loadError = "Memory allocation failed";
-			scriptState = ERRORED;
 			printf("Failed to allocate memory for script\n");
 		}
 	} else {
+		// MainLoop shows the error screen (loadError says why)
 		loadError = String("HTTP error: ") + String::Format(fetch->status);
-		scriptState = ERRORED;
 		printf("Failed to download %s: HTTP %d\n", fetch->url, fetch->status);
 	}
+	scriptFetchDone = true;
 
-	emscripten_fetch_close(fetch);
+	CloseAssetFetch(fetch);
 }
 
 void fetchScript(const char *url) {
 	printf("Fetching script from %s...\n", url);
 
-	emscripten_fetch_attr_t attr;
-	emscripten_fetch_attr_init(&attr);
-	strcpy(attr.requestMethod, "GET");
-	attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
-	attr.onsuccess = onScriptFetched;
-	attr.onerror = onScriptFetched;  // Same handler checks status
+	FetchAsset(url, onScriptFetched);
+}
+
+//--------------------------------------------------------------------------------
+// Precompiled bundle loading (see ScriptBundle.h and tools/msrlc.cpp)
+//--------------------------------------------------------------------------------
+
+// We fetch main.msb, main.ms and the import manifest all at once, so a
+// missing or out-of-date bundle costs no extra round trip.  When both are
+// in, the bundle's main module is used only if main.ms is the size it was
+// built from.  In MSRLWEB_DEV builds we also check (with a HEAD request per
+// module, before starting) that each library's source is the same size and
+// age as when the bundle was built; edited modules are dropped from the
+// bundle and loaded from source instead.
+
+static std::vector<BundledModule> bundledModules;
+static bool bundleFetchDone = false;	// bundle fetched (and checked) or absent
+
+#ifdef MSRLWEB_DEV
+static std::vector<bool> bundledModuleStale;
+static int bundleChecksPending = 0;
+
+static void FinishBundleCheck() {
+	std::vector<BundledModule> current;
+	for (size_t i = 0; i < bundledModules.size(); i++) {
+		if (!bundledModuleStale[i]) current.push_back(bundledModules[i]);
+	}
+	bundledModules.swap(current);
+	bundledModuleStale.clear();
+	bundleFetchDone = true;
+}
+
+static void onBundleSourceStat(AssetStat *stat) {
+	size_t index = (size_t)stat->userData;
+	// If the source can't be found, there's nothing better to fall back to
+	if (stat->status == 200 && !BundledSourceMatches(bundledModules[index], stat->size, stat->modified)) {
+		printf("%s has changed since main.msb was built; using the source\n", stat->url);
+		bundledModuleStale[index] = true;
+	}
+	CloseAssetStat(stat);
+	if (--bundleChecksPending == 0) FinishBundleCheck();
+}
+#endif
+
+// Drop the bundle's main module if main.ms was fetched and isn't the size
+// the bundle was built from
+static void CheckBundledMain() {
+	if (scriptSource.empty()) return;
+	for (size_t i = 0; i < bundledModules.size(); i++) {
+		if (bundledModules[i].name.empty()
+			&& !BundledSourceMatches(bundledModules[i], scriptSource.LengthB(), 0)) {
+			printf("main.ms has changed since main.msb was built; using the source\n");
+			bundledModules.erase(bundledModules.begin() + i);
+			return;
+		}
+	}
+}
+
+void onBundleFetched(AssetFetch *fetch) {
+	if (fetch->status == 200) {
+		if (DecodeScriptBundle((const unsigned char*)fetch->data, (long)fetch->numBytes, bundledModules)) {
+			printf("Loaded precompiled bundle %s (%d modules)\n", fetch->url, (int)bundledModules.size());
+		} else {
+			bundledModules.clear();
+		}
+	}
+	CloseAssetFetch(fetch);
+
+	// A missing bundle is normal (e.g. during development); we just use source
+#ifdef MSRLWEB_DEV
+	if (!bundledModules.empty()) {
+		bundledModuleStale.assign(bundledModules.size(), false);
+		bundleChecksPending = (int)bundledModules.size();
+		for (size_t i = 0; i < bundledModules.size(); i++) {
+			String url = String("assets/") + bundledModules[i].sourcePath;
+			StatAsset(url.c_str(), onBundleSourceStat, (void*)i);
+		}
+		return;
+	}
+#endif
+	bundleFetchDone = true;
+}
+
+void fetchBundle(const char *url) {
+	FetchAsset(url, onBundleFetched);
+}
+
+//--------------------------------------------------------------------------------
+// Module registry
+//--------------------------------------------------------------------------------
+// Every library we load is recorded here by name, with its source, its parsed
+// import function, and (once it has run) the map it produced.  A library is
+// fetched and parsed at most once, and run at most once per script run, so
+// several modules importing the same utility all share one map.
+
+struct CachedModule {
+	String libname;
+	String source;			// as fetched (empty for precompiled modules)
+	FunctionStorage *func;	// parsed import function
+	Value map;				// what running func returned; null until it has run
+	CachedModule() : func(nullptr) {}
+};
+
+static std::vector<CachedModule*> moduleCache;
+
+static CachedModule* FindCachedModule(const String& libname) {
+	for (CachedModule *mod : moduleCache) {
+		if (mod->libname == libname) return mod;
+	}
+	return nullptr;
+}
+
+static CachedModule* CacheModule(const String& libname, const String& source, FunctionStorage *func) {
+	CachedModule *mod = FindCachedModule(libname);
+	if (!mod) {
+		mod = new CachedModule();
+		mod->libname = libname;
+		moduleCache.push_back(mod);
+	}
+	mod->source = source;
+	mod->func = func;
+	mod->map = Value::null;
+	return mod;
+}
+
+// Forget the module maps (which belong to the previous run's globals), but
+// keep the sources and parsed code, so restarting the script needn't fetch
+// or parse anything again.
+static void ResetModuleMaps() {
+	for (CachedModule *mod : moduleCache) mod->map = Value::null;
+}
+
+//--------------------------------------------------------------------------------
+// Import prefetching
+//--------------------------------------------------------------------------------
+// While main.ms is still LOADING, we scan it for import statements and fetch
+// the whole import graph at once, parsing each module as it arrives (and
+// scanning it for imports of its own).  The import intrinsic then only has
+// to run a module that's already parsed, instead of fetching one library at
+// a time while the script runs.
+
+// Search paths for libraries, in order (shared with the import intrinsic)
+static const char* importSearchPaths[] = { "assets/", "assets/lib/" };
+
+// Where each library lives, from assets/import_manifest.txt (written by
+// msrlc, with or without a bundle; see tools/msrlc.cpp).  It's fetched at
+// startup, along with main.ms, and only waited for before prefetching
+// imports.  Libraries not listed are requested from every search path at
+// once.
+static std::vector<std::pair<String, String>> importManifest;	// libname, path
+static bool manifestFetchDone = false;
+
+struct PrefetchedModule {
+	String libname;
+	AssetFetch* fetches[2];	// one per candidate path
+	int pathCount;
+	int doneCount;
+	PrefetchedModule() : pathCount(0), doneCount(0) { fetches[0] = fetches[1] = nullptr; }
+};
+
+static std::vector<PrefetchedModule*> prefetchedModules;
+static int prefetchesPending = 0;
+static bool prefetchStarted = false;
+
+// Copy a fetched response into a (null-terminated) String
+static String FetchedText(AssetFetch *fetch) {
+	char* text = (char*)malloc(fetch->numBytes + 1);
+	if (!text) return String();
+	memcpy(text, fetch->data, fetch->numBytes);
+	text[fetch->numBytes] = '\0';
+	String result(text);
+	free(text);
+	return result;
+}
+
+void onManifestFetched(AssetFetch *fetch) {
+	if (fetch->status == 200) {
+		// Each line is: libname <whitespace> path
+		String text = FetchedText(fetch);
+		const char *p = text.c_str();
+		while (*p) {
+			const char *lineEnd = strchr(p, '\n');
+			if (!lineEnd) lineEnd = p + strlen(p);
+			const char *sep = p;
+			while (sep < lineEnd && *sep != ' ' && *sep != '\t') sep++;
+			const char *pathStart = sep;
+			while (pathStart < lineEnd && (*pathStart == ' ' || *pathStart == '\t')) pathStart++;
+			const char *pathEnd = lineEnd;
+			while (pathEnd > pathStart && (pathEnd[-1] == '\r' || pathEnd[-1] == ' ')) pathEnd--;
+			if (sep > p && pathEnd > pathStart) {
+				importManifest.push_back(std::make_pair(String(p, sep - p), String(pathStart, pathEnd - pathStart)));
+			}
+			p = *lineEnd ? lineEnd + 1 : lineEnd;
+		}
+		printf("Loaded import manifest (%d entries)\n", (int)importManifest.size());
+	}
+	manifestFetchDone = true;
+
+	CloseAssetFetch(fetch);
+}
+
+void fetchImportManifest(const char *url) {
+	FetchAsset(url, onManifestFetched);
+}
+
+static PrefetchedModule* FindPrefetchedModule(const String& libname) {
+	for (PrefetchedModule *mod : prefetchedModules) {
+		if (mod->libname == libname) return mod;
+	}
+	return nullptr;
+}
+
+static void PrefetchImports(const String& source);
+
+static void onPrefetchFetched(AssetFetch *fetch) {
+	PrefetchedModule *mod = (PrefetchedModule*)fetch->userData;
+	mod->doneCount++;
+	if (mod->doneCount < mod->pathCount) return;  // still waiting on another candidate
+
+	// Take the first candidate that succeeded, in search-path order
+	bool found = false;
+	for (int i = 0; i < mod->pathCount; i++) {
+		AssetFetch *f = mod->fetches[i];
+		if (!found && f->status == 200) {
+			found = true;
+			String source = FetchedText(f);
+			try {
+				Parser parser;
+				parser.errorContext = mod->libname + ".ms";
+				parser.Parse(source);
+				CacheModule(mod->libname, source, parser.CreateImport());
+				printf("Prefetched %s from %s\n", mod->libname.c_str(), f->url);
+				PrefetchImports(source);
+			} catch (MiniscriptException& mse) {
+				// Leave it to the import intrinsic, which will fetch and parse
+				// it again and report the error the usual way.
+				printf("Prefetch of %s failed to compile: %s\n", mod->libname.c_str(), mse.message.c_str());
+			}
+		}
+		CloseAssetFetch(f);
+		mod->fetches[i] = nullptr;
+	}
+	// Once the whole graph is in, the module cache has everything we need
+	if (--prefetchesPending == 0) {
+		for (PrefetchedModule *m : prefetchedModules) delete m;
+		prefetchedModules.clear();
+	}
+}
+
+static void PrefetchImports(const String& source) {
+	std::vector<String> names;
+	FindImportNames(source, names);
+	for (const String& libname : names) {
+		if (libname.IndexOfB('/') >= 0 || FindPrefetchedModule(libname) || FindCachedModule(libname)
+			|| FindBundledModule(bundledModules, libname)) continue;
+
+		PrefetchedModule *mod = new PrefetchedModule();
+		mod->libname = libname;
+		prefetchedModules.push_back(mod);
+
+		std::vector<String> paths;
+		for (auto& entry : importManifest) {
+			if (entry.first == libname) { paths.push_back(entry.second); break; }
+		}
+		if (paths.empty()) {
+			for (const char *searchPath : importSearchPaths) paths.push_back(String(searchPath) + libname + ".ms");
+		}
 
-	emscripten_fetch(&attr, url);
+		mod->pathCount = (int)paths.size();
+		prefetchesPending++;
+		for (int i = 0; i < mod->pathCount; i++) {
+			mod->fetches[i] = FetchAsset(paths[i].c_str(), onPrefetchFetched, mod);
+		}
+	}
 }
 
 //--------------------------------------------------------------------------------
@@ -100,7 +370,7 @@ void fetchScript(const char *url) {
 
 // Track import fetches
 struct ImportFetchData {
-	emscripten_fetch_t* fetch;
+	AssetFetch* fetch;
 	bool completed;
 	int status;
 	String libname;
@@ -112,7 +382,7 @@ static std::map<long, ImportFetchData> activeImportFetches;
 static long nextImportFetchId = 1;
 
 // Callback when import fetch completes
-static void import_fetch_completed(emscripten_fetch_t *fetch) {
+static void import_fetch_completed(AssetFetch *fetch) {
 	for (auto& pair : activeImportFetches) {
 		if (pair.second.fetch == fetch) {
 			pair.second.completed = true;
@@ -128,8 +398,11 @@ static IntrinsicResult intrinsic_import(Context *context, IntrinsicResult partia
 	if (!partialResult.Done() && partialResult.Result().type == ValueType::String) {
 		// The import function has finished, and stored its result in Temp 0.
 		Value importedValues = context->GetTemp(0);
-		// Store these imported values in the parent context under the library name
+		// Store these imported values in the parent context under the library
+		// name, and remember them so later imports of this library share them
 		String libname = partialResult.Result().ToString();
+		CachedModule *cached = FindCachedModule(libname);
+		if (cached) cached->map = importedValues;
 		Context *callerContext = context->parent;
 		if (callerContext) {
 			callerContext->SetVar(libname, importedValues);
@@ -149,18 +422,19 @@ static IntrinsicResult intrinsic_import(Context *context, IntrinsicResult partia
 
 		if (!data.completed) {
 			// Still loading
+			NoteScriptWaiting();
 			return partialResult;
 		}
 
 		// Fetch is complete
-		emscripten_fetch_t* fetch = data.fetch;
+		AssetFetch* fetch = data.fetch;
 		String libname = data.libname;
 
 		if (data.status == 200) {
 			// Success - parse the module source
 			char* moduleData = (char*)malloc(fetch->numBytes + 1);
 			if (!moduleData) {
-				emscripten_fetch_close(fetch);
+				CloseAssetFetch(fetch);
 				activeImportFetches.erase(it);
 				RuntimeException("import: memory allocation failed").raise();
 			}
@@ -169,7 +443,7 @@ static IntrinsicResult intrinsic_import(Context *context, IntrinsicResult partia
 			String moduleSource(moduleData);
 			free(moduleData);
 
-			emscripten_fetch_close(fetch);
+			CloseAssetFetch(fetch);
 			activeImportFetches.erase(it);
 
 			// Parse the code and build a function around it
@@ -177,6 +451,7 @@ static IntrinsicResult intrinsic_import(Context *context, IntrinsicResult partia
 			parser.errorContext = libname + ".ms";
 			parser.Parse(moduleSource);
 			FunctionStorage *import = parser.CreateImport();
+			CacheModule(libname, moduleSource, import);
 			context->vm->ManuallyPushCall(import, Value::Temp(0));
 
 			// Return partial result with the lib name (string type)
@@ -184,28 +459,20 @@ static IntrinsicResult intrinsic_import(Context *context, IntrinsicResult partia
 			return IntrinsicResult(libname, false);
 		} else {
 			// Error loading file - try next search path if available
-			emscripten_fetch_close(fetch);
+			CloseAssetFetch(fetch);
 			int nextPathIndex = data.searchPathIndex + 1;
 			activeImportFetches.erase(it);
 
-			const char* searchPaths[] = { "assets/", "assets/lib/" };
 			if (nextPathIndex < 2) {
 				// Try the next path
-				String path = String(searchPaths[nextPathIndex]) + libname + ".ms";
+				String path = String(importSearchPaths[nextPathIndex]) + libname + ".ms";
 
 				long newFetchId = nextImportFetchId++;
 				ImportFetchData& newData = activeImportFetches[newFetchId];
 				newData.libname = libname;
 				newData.searchPathIndex = nextPathIndex;
 
-				emscripten_fetch_attr_t attr;
-				emscripten_fetch_attr_init(&attr);
-				strcpy(attr.requestMethod, "GET");
-				attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
-				attr.onsuccess = import_fetch_completed;
-				attr.onerror = import_fetch_completed;
-
-				newData.fetch = emscripten_fetch(&attr, path.c_str());
+				newData.fetch = FetchAsset(path.c_str(), import_fetch_completed);
 
 				return IntrinsicResult(Value((double)newFetchId), false);
 			} else {
@@ -224,7 +491,24 @@ static IntrinsicResult intrinsic_import(Context *context, IntrinsicResult partia
 		RuntimeException("import: argument must be library name, not path").raise();
 	}
 
-	// Try to find the file - start with assets/
+	// Precompiled and prefetched modules need no fetch or parse; if one
+	// has already run, its map is simply shared with this caller too
+	CachedModule *cached = FindCachedModule(libname);
+	if (!cached) {
+		FunctionStorage *bundled = FindBundledModule(bundledModules, libname);
+		if (bundled) cached = CacheModule(libname, String(), bundled);
+	}
+	if (cached && cached->map.type != ValueType::Null) {
+		Context *callerContext = context->parent;
+		if (callerContext) callerContext->SetVar(libname, cached->map);
+		return IntrinsicResult::Null;
+	}
+	if (cached) {
+		context->vm->ManuallyPushCall(cached->func, Value::Temp(0));
+		return IntrinsicResult(libname, false);
+	}
+
+	// Not loaded yet (e.g. a computed name); try to find the file - start with assets/
 	String path = String("assets/") + libname + ".ms";
 
 	// Start async fetch
@@ -233,14 +517,7 @@ static IntrinsicResult intrinsic_import(Context *context, IntrinsicResult partia
 	data.libname = libname;
 	data.searchPathIndex = 0;
 
-	emscripten_fetch_attr_t attr;
-	emscripten_fetch_attr_init(&attr);
-	strcpy(attr.requestMethod, "GET");
-	attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
-	attr.onsuccess = import_fetch_completed;
-	attr.onerror = import_fetch_completed;
-
-	data.fetch = emscripten_fetch(&attr, path.c_str());
+	data.fetch = FetchAsset(path.c_str(), import_fetch_completed);
 
 	// Return the fetch ID as partial result (number type)
 	return IntrinsicResult(Value((double)fetchId), false);
@@ -276,14 +553,29 @@ void InitMiniScript() {
 //--------------------------------------------------------------------------------
 
 void RunScript() {
-	if (scriptSource.empty()) {
-		PrintErr("No script to run");
-		return;
-	}
+	ResetModuleMaps();
+
+	FunctionStorage *mainFunc = FindBundledModule(bundledModules, "");
+	if (mainFunc) {
+		printf("Loading precompiled script...\n");
+		interpreter->Reset("");
+		interpreter->Compile();
+		// The bundle stores main.ms as an import function, which ends with
+		// `return locals`; at global scope we want everything but that line.
+		Context *globalContext = interpreter->vm->GetGlobalContext();
+		for (long i = 0; i < mainFunc->code.Count() - 1; i++) {
+			globalContext->code.Add(mainFunc->code[i]);
+		}
+	} else {
+		if (scriptSource.empty()) {
+			PrintErr("No script to run");
+			return;
+		}
 
-	printf("Compiling script...\n");
-	interpreter->Reset(scriptSource);
-	interpreter->Compile();
+		printf("Compiling script...\n");
+		interpreter->Reset(scriptSource);
+		interpreter->Compile();
+	}
 
 	printf("Starting script execution...\n");
 	scriptState = RUNNING;
@@ -296,25 +588,53 @@ void RunScript() {
 //--------------------------------------------------------------------------------
 
 void MainLoop() {
-	// Start the script when it's loaded but not yet started
-	if (scriptState == LOADING && !scriptSource.empty()) {
-		RunScript();
+	BeginFrameTiming();
+
+	// Deliver any fetches (script, imports, assets) that finished since last frame
+	PollAssetFetches();
+	PollDecodeJobs();
+
+	// Start the script when it's loaded but not yet started.  We prefer the
+	// bundle, unless main.ms has changed since it was built.  Scripts usually
+	// load assets right away, so we wait for the asset pack too.
+	if (scriptState == LOADING && bundleFetchDone && scriptFetchDone && !IsAssetPackLoading()) {
+		if (!prefetchStarted) CheckBundledMain();
+		if (FindBundledModule(bundledModules, "")) {
+			RunScript();
+		} else if (!scriptSource.empty()) {
+			// Fetch the whole import graph before starting the script
+			if (!prefetchStarted && manifestFetchDone) {
+				prefetchStarted = true;
+				PrefetchImports(scriptSource);
+			}
+			if (prefetchStarted && prefetchesPending == 0) RunScript();
+		} else {
+			scriptState = ERRORED;	// loadError says why
+		}
 	}
 
 	if (scriptState == RUNNING) {
+		// Free textures, sounds, etc. the script has let go of since last frame
+		CollectDroppedResources();
+
 		// Script is running - hand control to MiniScript
 		// MiniScript will handle BeginDrawing/EndDrawing and everything else
 		if (!interpreter->Done()) {
+			// Give the VM whatever is left of the frame budget after the browser's share
+			double slice = BeginScriptSlice();
 			try {
-				interpreter->RunUntilDone(0.1, false);  // Run until yield or timeout
+				interpreter->RunUntilDone(slice, false);  // Run until yield or timeout
 			} catch (MiniscriptException& mse) {
 				PrintErr("Runtime Exception: " + mse.message);
 				interpreter->vm->Stop();
 				scriptState = ERRORED;
+				ReportLiveResources();
 			}
+			EndScriptSlice();
 		} else {
 			scriptState = COMPLETE;
 			printf("Script finished\n");
+			ReportLiveResources();
 		}
 	} else {
 		// Show loading, error, or completion screen
@@ -330,6 +650,12 @@ void MainLoop() {
 			int dots = ((int)(GetTime() * 2)) % 4;
 			const char* dotStr[] = {"", ".", "..", "..."};
 			DrawText(dotStr[dots], 250, 50, 20, GRAY);
+
+			// Asset pack progress bar
+			if (IsAssetPackLoading()) {
+				DrawRectangleLines(10, 80, 300, 12, GRAY);
+				DrawRectangle(12, 82, (int)(296 * GetAssetPackProgress()), 8, DARKBLUE);
+			}
 		} else if (scriptState == ERRORED) {
 			// Error screen
 			DrawText("MSRLWeb - MiniScript + Raylib", 10, 10, 30, DARKBLUE);
@@ -355,6 +681,8 @@ void MainLoop() {
 
 		EndDrawing();
 	}
+
+	EndFrameTiming();
 }
 
 //--------------------------------------------------------------------------------
@@ -391,8 +719,17 @@ int main() {
 	// Initialize MiniScript
 	InitMiniScript();
 
-	// Start fetching the main script
+	// Start fetching everything the script might need at once: the asset
+	// pack and precompiled bundle (if any), main.ms in case there's no
+	// bundle (or it's out of date), and the import manifest.  A pack takes
+	// priority over the loose files, whatever their age, so development
+	// builds skip it and always load what's on the server.
+#ifndef MSRLWEB_DEV
+	FetchAssetPack("assets/assets.pack");
+#endif
+	fetchBundle("assets/main.msb");
 	fetchScript("assets/main.ms");
+	fetchImportManifest("assets/import_manifest.txt");
 
 	// Main loop
 	#ifdef PLATFORM_WEB
@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# Build the runtime in each async mode (see MSRLWEB_ASYNC_MODE in
+# CMakeLists.txt) and compare them.
+#
+# Code size is reported here.  For startup time and intrinsic call
+# throughput, each build gets tools/bench/main.ms as its main script; serve
+# the printed directories and compare the console output in the browser.
+
+set -e
+
+MODES=${@:-ASYNCIFY NONE}
+
+printf "%-10s %12s %12s %12s\n" "mode" "wasm" "wasm (gz)" "js"
+for MODE in $MODES; do
+    DIR="build-bench-$(echo $MODE | tr '[:upper:]' '[:lower:]')"
+    emcmake cmake -S . -B "$DIR" -DCMAKE_BUILD_TYPE=Release -DMSRLWEB_ASYNC_MODE=$MODE > "$DIR.log" 2>&1
+    cmake --build "$DIR" --target msrlweb >> "$DIR.log" 2>&1
+
+    # Swap in the benchmark script (and no bundle, so it's the one that runs)
+    cp tools/bench/main.ms "$DIR/assets/main.ms"
+    rm -f "$DIR/assets/main.msb"
+
+    WASM="$DIR/msrlweb.wasm"
+    printf "%-10s %12d %12d %12d\n" "$MODE" \
+        $(wc -c < "$WASM") $(gzip -9 -c "$WASM" | wc -c) $(wc -c < "$DIR/msrlweb.js")
+done
+
+echo ""
+echo "To measure startup and call throughput, serve each build, e.g.:"
+for MODE in $MODES; do
+    echo "  (cd build-bench-$(echo $MODE | tr '[:upper:]' '[:lower:]') && python3 -m http.server 8000)"
+done
+echo "then open http://localhost:8000/msrlweb.html and compare the console output."
@@ -0,0 +1,130 @@
+//
+// msrlc.cpp
+// MSRLWeb
+//
+// Offline script compiler: parses assets/main.ms and everything it
+// (transitively) imports, and writes the compiled TAC to assets/main.msb.
+// It also writes assets/import_manifest.txt, which tells the runtime where
+// each library lives so it can prefetch them without probing search paths.
+// Built with Emscripten for Node (see CMakeLists.txt); run it as:
+//
+//     node build/msrlc.js assets
+//
+// or, to write only the manifest (for running from source during
+// development, with no bundle to go stale):
+//
+//     node build/msrlc.js --manifest-only assets
+//
+
+#include "ScriptBundle.h"
+#include "MiniscriptInterpreter.h"
+#include "MiniscriptParser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+using namespace MiniScript;
+
+// Read a whole text file, or return false if it can't be opened
+static bool ReadFile(const String& path, String& outText) {
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f) return false;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	char *buf = (char*)malloc(size + 1);
+	long got = (long)fread(buf, 1, size, f);
+	buf[got] = '\0';
+	fclose(f);
+	outText = String(buf);
+	free(buf);
+	return true;
+}
+
+// Record where a module's source is, and its size and modification time
+static void SetSource(BundledModule& module, const String& assetsDir, const String& relPath, const String& source) {
+	module.sourcePath = relPath;
+	module.sourceSize = source.LengthB();
+	struct stat st;
+	module.sourceTime = stat((assetsDir + "/" + relPath).c_str(), &st) == 0 ? (double)st.st_mtime : 0;
+}
+
+// Compile one source file into an import function
+static FunctionStorage* Compile(const String& source, const String& errorContext) {
+	Parser parser;
+	parser.errorContext = errorContext;
+	parser.Parse(source);
+	return parser.CreateImport();
+}
+
+int main(int argc, char *argv[]) {
+	bool manifestOnly = false;
+	if (argc > 1 && String(argv[1]) == "--manifest-only") {
+		manifestOnly = true;
+		argc--;
+		argv++;
+	}
+	String assetsDir = argc > 1 ? String(argv[1]) : String("assets");
+	String outPath = argc > 2 ? String(argv[2]) : assetsDir + "/main.msb";
+
+	std::vector<BundledModule> modules;
+	std::vector<String> pending;
+	String manifest;
+
+	try {
+		String source;
+		if (!ReadFile(assetsDir + "/main.ms", source)) {
+			fprintf(stderr, "msrlc: can't read %s/main.ms\n", assetsDir.c_str());
+			return 1;
+		}
+		modules.push_back(BundledModule("", Compile(source, "main.ms")));
+		SetSource(modules.back(), assetsDir, "main.ms", source);
+		FindImportNames(source, pending);
+
+		// Same search order as the import intrinsic: assets/, then assets/lib/
+		for (size_t i = 0; i < pending.size(); i++) {
+			String libname = pending[i];
+			String relPath = libname + ".ms";
+			if (!ReadFile(assetsDir + "/" + relPath, source)) {
+				relPath = "lib/" + libname + ".ms";
+				if (!ReadFile(assetsDir + "/" + relPath, source)) {
+					fprintf(stderr, "msrlc: warning: library not found: %s\n", libname.c_str());
+					continue;
+				}
+			}
+			printf("msrlc: %s -> %s\n", libname.c_str(), relPath.c_str());
+			manifest += libname + "\tassets/" + relPath + "\n";
+			modules.push_back(BundledModule(libname, Compile(source, libname + ".ms")));
+			SetSource(modules.back(), assetsDir, relPath, source);
+			FindImportNames(source, pending);
+		}
+	} catch (MiniscriptException& mse) {
+		fprintf(stderr, "msrlc: %s\n", mse.message.c_str());
+		return 1;
+	}
+
+	FILE *out;
+	if (!manifestOnly) {
+		std::vector<unsigned char> bytes = EncodeScriptBundle(modules);
+		out = fopen(outPath.c_str(), "wb");
+		if (!out) {
+			fprintf(stderr, "msrlc: can't write %s\n", outPath.c_str());
+			return 1;
+		}
+		fwrite(bytes.data(), 1, bytes.size(), out);
+		fclose(out);
+		printf("msrlc: wrote %d module(s), %d bytes, to %s\n",
+			(int)modules.size(), (int)bytes.size(), outPath.c_str());
+	}
+
+	String manifestPath = assetsDir + "/import_manifest.txt";
+	out = fopen(manifestPath.c_str(), "wb");
+	if (!out) {
+		fprintf(stderr, "msrlc: can't write %s\n", manifestPath.c_str());
+		return 1;
+	}
+	fwrite(manifest.c_str(), 1, manifest.LengthB(), out);
+	fclose(out);
+	printf("msrlc: wrote %s\n", manifestPath.c_str());
+	return 0;
+}
@@ -0,0 +1,92 @@
+//
+// msrlpack.cpp
+// MSRLWeb
+//
+// Asset packer: bundles every file under assets/ into assets/assets.pack,
+// which the runtime fetches in one request and serves from memory.
+// Built with Emscripten for Node (see CMakeLists.txt); run it as:
+//
+//     node build/msrlpack.js assets [out] [--no-compress]
+//
+
+#include "AssetPack.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static bool ReadFile(const std::string& path, std::vector<unsigned char>& outData) {
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f) return false;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	outData.resize(size);
+	long got = size > 0 ? (long)fread(outData.data(), 1, size, f) : 0;
+	fclose(f);
+	return got == size;
+}
+
+static bool EndsWith(const std::string& s, const char *suffix) {
+	size_t n = strlen(suffix);
+	return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// Gather files under dir (recursively), keyed by prefix + relative path
+static void CollectFiles(const std::string& dir, const std::string& prefix, std::vector<AssetPackInput>& files) {
+	DIR *d = opendir(dir.c_str());
+	if (!d) return;
+	while (struct dirent *entry = readdir(d)) {
+		std::string name = entry->d_name;
+		if (name.empty() || name[0] == '.') continue;	// also skips . and ..
+		std::string path = dir + "/" + name;
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0) continue;
+		if (S_ISDIR(st.st_mode)) {
+			CollectFiles(path, prefix + name + "/", files);
+		} else if (S_ISREG(st.st_mode) && !EndsWith(name, ".pack")) {
+			AssetPackInput f;
+			f.path = prefix + name;
+			if (ReadFile(path, f.data)) files.push_back(f);
+			else fprintf(stderr, "msrlpack: warning: can't read %s\n", path.c_str());
+		}
+	}
+	closedir(d);
+}
+
+int main(int argc, char *argv[]) {
+	bool compress = true;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--no-compress") == 0) compress = false;
+		else args.push_back(argv[i]);
+	}
+	std::string assetsDir = args.size() > 0 ? args[0] : "assets";
+	std::string outPath = args.size() > 1 ? args[1] : assetsDir + "/assets.pack";
+
+	// Scripts load assets as "assets/...", so that's how they're keyed
+	std::vector<AssetPackInput> files;
+	CollectFiles(assetsDir, "assets/", files);
+	if (files.empty()) {
+		fprintf(stderr, "msrlpack: no files found in %s\n", assetsDir.c_str());
+		return 1;
+	}
+	std::sort(files.begin(), files.end(),
+		[](const AssetPackInput& a, const AssetPackInput& b) { return a.path < b.path; });
+
+	size_t totalSize = 0;
+	for (const AssetPackInput& f : files) totalSize += f.data.size();
+	std::vector<unsigned char> bytes = EncodeAssetPack(files, compress);
+
+	FILE *out = fopen(outPath.c_str(), "wb");
+	if (!out) {
+		fprintf(stderr, "msrlpack: can't write %s\n", outPath.c_str());
+		return 1;
+	}
+	fwrite(bytes.data(), 1, bytes.size(), out);
+	fclose(out);
+	printf("msrlpack: packed %d file(s), %d bytes, into %s (%d bytes)\n",
+		(int)files.size(), (int)totalSize, outPath.c_str(), (int)bytes.size());
+	return 0;
+}